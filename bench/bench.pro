@@ -0,0 +1,16 @@
+# Standalone benchmark of the polygon boolean layer, no Qt modules needed.
+# Runs a few regression checks first and exits with 1 if one fails.
+QT -= core gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = clipbench
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    ../clipper.cpp \
+    ../polyclip.cpp \
+    ../triangulate.cpp
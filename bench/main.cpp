@@ -0,0 +1,250 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#include "polyclip.h"
+#include "triangulate.h"
+
+#define M 100000.0
+
+static Path circle(double cx, double cy, double r, int segments)
+{
+    Path res;
+    for(int i=0; i<segments; i++) {
+        double phi = 2 * M_PI * i / segments;
+        res << IntPoint(std::llround((cx + cos(phi) * r) * M), std::llround((cy + sin(phi) * r) * M));
+    }
+    return res;
+}
+
+// a single involute-ish tooth: flanks sampled along a circle arc, closed at the root
+static Path tooth(double r, double height, double width, int samples)
+{
+    Path res;
+    for(int i=0; i<=samples; i++) {
+        double t = static_cast<double>(i) / samples;
+        double x = (t - 0.5) * width;
+        double y = r + height * sqrt(1.0 - 4 * (t - 0.5) * (t - 0.5));
+        res << IntPoint(std::llround(x * M), std::llround(y * M));
+    }
+    return res;
+}
+
+static double clipperArea(ClipType ct, const Path& s, const Path& c, Paths& solution)
+{
+    Clipper cl;
+    cl.AddPath(s, ptSubject, true);
+    cl.AddPath(c, ptClip, true);
+    cl.Execute(ct, solution, pftNonZero, pftNonZero);
+    double a = 0;
+    for(auto& p : solution) a += Area(p);
+    return a;
+}
+
+static double layerArea(ClipType ct, const Path& s, const Path& c, Paths& solution)
+{
+    polyBoolean(ct, s, c, solution);
+    double a = 0;
+    for(auto& p : solution) a += Area(p);
+    return a;
+}
+
+static double timeIt(int iterations, const std::function<void()>& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(int i=0; i<iterations; i++) f();
+    std::chrono::duration<double, std::micro> d = std::chrono::steady_clock::now() - start;
+    return d.count() / iterations;
+}
+
+static void bench(const char* name, ClipType ct, const Path& s, const Path& c, int iterations)
+{
+    Paths sol;
+    double a1 = clipperArea(ct, s, c, sol);
+    double a2 = layerArea(ct, s, c, sol);
+
+    double t1 = timeIt(iterations, [&]() { Paths r; clipperArea(ct, s, c, r); });
+    double t2 = timeIt(iterations, [&]() { Paths r; layerArea(ct, s, c, r); });
+
+    printf("%-34s clipper %9.2f us   convex %9.2f us   x%5.2f   area diff %.2e\n",
+           name, t1, t2, t1 / t2, a1 != 0 ? fabs(a1 - a2) / fabs(a1) : fabs(a2));
+}
+
+static void benchMinkowski(const char* name, const Path& pattern, const Path& path, int iterations)
+{
+    Paths s1, s2;
+    MinkowskiSum(pattern, path, s1, true);
+    MinkowskiSumParallel(pattern, path, s2, true, 4);
+    double a1 = 0, a2 = 0;
+    for(auto& p : s1) a1 += Area(p);
+    for(auto& p : s2) a2 += Area(p);
+
+    double t1 = timeIt(iterations, [&]() { Paths r; MinkowskiSum(pattern, path, r, true); });
+    double t2 = timeIt(iterations, [&]() { Paths r; MinkowskiSumParallel(pattern, path, r, true, 4); });
+
+    printf("%-34s serial  %9.2f us   threads %9.2f us   x%5.2f   area diff %.2e\n",
+           name, t1, t2, t1 / t2, fabs(a1 - a2) / fabs(a1));
+}
+
+static double openLength(const Path& open, const Path& clip)
+{
+    Clipper cl;
+    cl.AddPath(open, ptSubject, false);
+    cl.AddPath(clip, ptClip, true);
+    PolyTree tree;
+    cl.Execute(ctIntersection, tree);
+    Paths sol;
+    OpenPathsFromPolyTree(tree, sol);
+
+    double len = 0;
+    for(auto& p : sol)
+        for(size_t i=1; i<p.size(); i++)
+            len += std::hypot(double(p[i].X - p[i-1].X), double(p[i].Y - p[i-1].Y));
+    return len;
+}
+
+// a zigzag clipped as a whole has to keep as much length as its segments
+// clipped one by one, open paths have extra minima behind skip edges
+static int checkOpenPaths()
+{
+    Path rect;
+    rect << IntPoint(-50000, -50000) << IntPoint(50000, -50000) << IntPoint(50000, 50000) << IntPoint(-50000, 50000);
+
+    int failed = 0;
+    srand(1);
+    for(int n=0; n<200; n++) {
+        Path zigzag;
+        for(int i=0; i<12; i++) zigzag << IntPoint((rand() % 200 - 100) * 1000, (rand() % 200 - 100) * 1000);
+
+        double whole = openLength(zigzag, rect), parts = 0;
+        for(size_t i=1; i<zigzag.size(); i++) {
+            Path seg;
+            seg << zigzag[i-1] << zigzag[i];
+            parts += openLength(seg, rect);
+        }
+        if(fabs(whole - parts) > 1e-3 * std::max(parts, 1.0)) failed++;
+    }
+
+    printf("%-34s %d of 200 differ\n", "open zigzag & rect", failed);
+    return failed;
+}
+
+static Path star(double cx, double cy, double r, int points)
+{
+    Path res;
+    for(int i=0; i<points; i++) {
+        double phi = 2 * M_PI * i / points;
+        double ri = r * (0.4 + 0.6 * rand() / RAND_MAX);
+        res << IntPoint(std::llround((cx + cos(phi) * ri) * M), std::llround((cy + sin(phi) * ri) * M));
+    }
+    return res;
+}
+
+// the triangles of a cap have to cover the outer ring minus its holes,
+// every bridge has to stay clear of all holes including its own
+static int checkCaps()
+{
+    int failed = 0;
+    srand(1);
+    for(int n=0; n<200; n++) {
+        Path outer = star(0, 0, 100, 40);
+        Paths holes;
+        for(int i=0; i<6; i++) {
+            double phi = 2 * M_PI * rand() / RAND_MAX;
+            holes.push_back(star(cos(phi) * 25, sin(phi) * 25, 15, 12));
+        }
+
+        Clipper cl;
+        cl.AddPath(outer, ptSubject, true);
+        cl.AddPaths(holes, ptClip, true);
+        PolyTree tree;
+        cl.Execute(ctDifference, tree, pftNonZero, pftNonZero);
+
+        for(PolyNode* node = tree.GetFirst(); node; node = node->GetNext()) {
+            if(node->IsHole()) continue;
+            Paths rings(1, node->Contour);
+            double expected = Area(node->Contour);
+            for(auto child : node->Childs) {
+                rings.push_back(child->Contour);
+                expected += Area(child->Contour);
+            }
+
+            std::vector<IntPoint> pts;
+            for(auto& r : rings) pts.insert(pts.end(), r.begin(), r.end());
+            std::vector<size_t> tris;
+            if(!triangulate(rings, tris)) {
+                failed++;
+                break;
+            }
+
+            double area = 0;
+            for(size_t i=0; i+2<tris.size(); i+=3) {
+                const IntPoint& a = pts[tris[i]];
+                const IntPoint& b = pts[tris[i+1]];
+                const IntPoint& c = pts[tris[i+2]];
+                area += 0.5 * (double(b.X - a.X) * double(c.Y - a.Y) - double(b.Y - a.Y) * double(c.X - a.X));
+            }
+            if(fabs(area - expected) > 1e-9 * fabs(expected)) {
+                failed++;
+                break;
+            }
+        }
+    }
+
+    printf("%-34s %d of 200 differ\n", "cap area of star with holes", failed);
+    return failed;
+}
+
+// a difference whose clip misses the subject returns the subject unswept,
+// it has to match the swept subject in area and orientation
+static int checkPassThrough()
+{
+    int failed = 0;
+    srand(1);
+    for(int n=0; n<200; n++) {
+        Path subject = star(0, 0, 100, 40);
+        if(n % 2) ReversePath(subject);
+        Path far = star(300, 0, 50, 12);
+
+        Clipper swept, passed;
+        swept.ReverseSolution(n % 4 >= 2);
+        passed.ReverseSolution(n % 4 >= 2);
+        swept.AddPath(subject, ptSubject, true);
+        passed.AddPath(subject, ptSubject, true);
+        passed.AddPath(far, ptClip, true);
+        Paths expected, result;
+        swept.Execute(ctUnion, expected, pftNonZero, pftNonZero);
+        passed.Execute(ctDifference, result, pftNonZero, pftNonZero);
+
+        if(expected.size() != 1 || result.size() != 1 || Area(expected[0]) != Area(result[0])) failed++;
+    }
+
+    printf("%-34s %d of 200 differ\n", "star - disjoint star", failed);
+    return failed;
+}
+
+int main()
+{
+    if(checkOpenPaths() || checkCaps() || checkPassThrough()) return 1;
+
+    Path blank = circle(0, 0, 100, 37);
+    Path blankFine = circle(0, 0, 100, 1000);
+    Path disc = circle(150, 0, 80, 37);
+    Path discFine = circle(150, 0, 80, 1000);
+    Path t = tooth(95, 12, 10, 32);
+
+    bench("circle & circle (37)", ctIntersection, blank, disc, 20000);
+    bench("circle & circle (1000)", ctIntersection, blankFine, discFine, 200);
+    bench("circle - circle (37)", ctDifference, blank, disc, 20000);
+    bench("circle - circle (1000)", ctDifference, blankFine, discFine, 500);
+    bench("tooth & circle (37)", ctIntersection, t, blank, 20000);
+    bench("circle (1000) - tooth", ctDifference, blankFine, t, 2000);
+    bench("circle (37) - tooth", ctDifference, blank, t, 20000);
+
+    benchMinkowski("tooth + circle path (300)", t, circle(0, 0, 100, 300), 20);
+    benchMinkowski("tooth + circle path (1000)", t, circle(0, 0, 100, 1000), 3);
+
+    return 0;
+}
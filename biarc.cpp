@@ -0,0 +1,212 @@
+#include "biarc.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const double pi = 3.14159265358979323846;
+
+// turning angle above which a vertex is treated as a corner
+static const double cornerAngle = 25.0 * pi / 180.0;
+
+struct sVec
+{
+    double x, y;
+};
+
+static sVec operator+(sVec a, sVec b) { return { a.x + b.x, a.y + b.y }; }
+static sVec operator-(sVec a, sVec b) { return { a.x - b.x, a.y - b.y }; }
+static sVec operator*(sVec a, double s) { return { a.x * s, a.y * s }; }
+static double dot(sVec a, sVec b) { return a.x * b.x + a.y * b.y; }
+static double len(sVec a) { return std::sqrt(dot(a, a)); }
+static sVec unit(sVec a) { double l = len(a); return l > 0 ? a * (1.0 / l) : a; }
+
+static sArcSegment makeLine(sVec a, sVec b)
+{
+    return { a.x, a.y, b.x, b.y, 0, 0, 0, 0 };
+}
+
+// arc from a to b leaving a in direction t
+static sArcSegment arcFromStart(sVec a, sVec t, sVec b)
+{
+    sVec n = { -t.y, t.x };
+    sVec ab = b - a;
+    double chord2 = dot(ab, ab);
+    double h = dot(n, ab);
+    // the sagitta is about h/4, below the six decimals of the output it is a line
+    if(std::fabs(h) < 4e-7)
+        return makeLine(a, b);
+    double s = chord2 / (2.0 * h);
+    sVec c = a + n * s;
+    return { a.x, a.y, b.x, b.y, c.x, c.y, std::fabs(s), s > 0 ? 1 : -1 };
+}
+
+// arc from a to b arriving at b in direction t
+static sArcSegment arcToEnd(sVec a, sVec b, sVec t)
+{
+    sArcSegment rev = arcFromStart(b, t * -1.0, a);
+    return { a.x, a.y, b.x, b.y, rev.cx, rev.cy, rev.r, -rev.dir };
+}
+
+static double sweep(const sArcSegment& s)
+{
+    double a0 = std::atan2(s.y0 - s.cy, s.x0 - s.cx);
+    double a1 = std::atan2(s.y1 - s.cy, s.x1 - s.cx);
+    double d = s.dir * (a1 - a0);
+    while(d < 0) d += 2 * pi;
+    return d;
+}
+
+static double distance(const sArcSegment& s, sVec q)
+{
+    sVec a = { s.x0, s.y0 }, b = { s.x1, s.y1 };
+    if(s.dir == 0) {
+        sVec ab = b - a;
+        double l2 = dot(ab, ab);
+        double t = l2 > 0 ? std::min(std::max(dot(q - a, ab) / l2, 0.0), 1.0) : 0.0;
+        return len(q - (a + ab * t));
+    }
+    sVec c = { s.cx, s.cy };
+    double a0 = std::atan2(s.y0 - s.cy, s.x0 - s.cx);
+    double d = s.dir * (std::atan2(q.y - s.cy, q.x - s.cx) - a0);
+    while(d < 0) d += 2 * pi;
+    if(d <= sweep(s))
+        return std::fabs(len(q - c) - s.r);
+    return std::min(len(q - a), len(q - b));
+}
+
+// biarc with equal tangent lengths from p1 (direction t1) to p2 (direction t2)
+static bool biarc(sVec p1, sVec t1, sVec p2, sVec t2, sArcSegment& arc1, sArcSegment& arc2)
+{
+    sVec v = p2 - p1;
+    sVec t = t1 + t2;
+    double vt = dot(v, t);
+    double denom = 2.0 * (1.0 - dot(t1, t2));
+    double d;
+
+    if(denom < 1e-12) {
+        double vt2 = dot(v, t2);
+        if(std::fabs(vt2) < 1e-12) return false;
+        d = dot(v, v) / (4.0 * vt2);
+    } else {
+        d = (-vt + std::sqrt(vt * vt + denom * dot(v, v))) / denom;
+    }
+    if(!(d > 0)) return false;
+
+    sVec pm = ((p1 + t1 * d) + (p2 - t2 * d)) * 0.5;
+
+    arc1 = arcFromStart(p1, t1, pm);
+    arc2 = arcToEnd(pm, p2, t2);
+
+    // anything sweeping half a circle is a loop, not a fit
+    return (arc1.dir == 0 || sweep(arc1) < pi) && (arc2.dir == 0 || sweep(arc2) < pi);
+}
+
+static bool fits(const std::vector<sVec>& p, size_t i, size_t j, const sArcSegment& a1, const sArcSegment& a2, double tolerance)
+{
+    for(size_t k=i; k<j; k++) {
+        sVec q = (p[k] + p[k+1]) * 0.5;
+        if(std::min(distance(a1, q), distance(a2, q)) > tolerance) return false;
+        if(k > i && std::min(distance(a1, p[k]), distance(a2, p[k])) > tolerance) return false;
+    }
+    return true;
+}
+
+static void push(std::vector<sArcSegment>& segments, const sArcSegment& s)
+{
+    if(s.x0 != s.x1 || s.y0 != s.y1)
+        segments.push_back(s);
+}
+
+void fitBiarcs(const Path& poly, double scale, double tolerance, std::vector<sArcSegment>& segments)
+{
+    segments.clear();
+
+    std::vector<sVec> pts;
+    for(auto& ip : poly) {
+        sVec v = { ip.X * scale, ip.Y * scale };
+        if(pts.empty() || pts.back().x != v.x || pts.back().y != v.y)
+            pts.push_back(v);
+    }
+    while(pts.size() > 1 && pts.front().x == pts.back().x && pts.front().y == pts.back().y)
+        pts.pop_back();
+
+    size_t n = pts.size();
+    if(n < 3) return;
+
+    // tangents on both sides of every vertex, they differ only at corners
+    std::vector<sVec> tin(n), tout(n);
+    std::vector<bool> corner(n);
+    size_t start = 0;
+    bool anyCorner = false;
+    for(size_t i=0; i<n; i++) {
+        sVec ein = unit(pts[i] - pts[(i+n-1)%n]);
+        sVec eout = unit(pts[(i+1)%n] - pts[i]);
+        corner[i] = std::acos(std::min(std::max(dot(ein, eout), -1.0), 1.0)) > cornerAngle;
+        if(corner[i]) {
+            tin[i] = ein;
+            tout[i] = eout;
+            if(!anyCorner) start = i;
+            anyCorner = true;
+        } else {
+            tin[i] = tout[i] = unit(ein + eout);
+        }
+    }
+
+    // unroll the loop from a corner, so no run has to wrap around
+    std::vector<sVec> p(n+1), ti(n+1), to(n+1);
+    std::vector<bool> c(n+1);
+    for(size_t k=0; k<=n; k++) {
+        size_t i = (start + k) % n;
+        p[k] = pts[i];
+        ti[k] = tin[i];
+        to[k] = tout[i];
+        c[k] = corner[i];
+    }
+
+    // a run may end at a corner but never pass through one
+    std::vector<size_t> limit(n+1);
+    limit[n] = n;
+    for(size_t k=n; k-- > 0; )
+        limit[k] = c[k+1] ? k+1 : limit[k+1];
+
+    size_t i = 0;
+    while(i < n) {
+        size_t best = 0;
+        sArcSegment b1, b2, a1, a2;
+        auto tryRun = [&](size_t j) {
+            if(!biarc(p[i], to[i], p[j], ti[j], a1, a2) || !fits(p, i, j, a1, a2, tolerance))
+                return false;
+            best = j;
+            b1 = a1;
+            b2 = a2;
+            return true;
+        };
+
+        // gallop to the first failing run length, then bisect back
+        size_t step = 1, lo = i, hi = limit[i] + 1;
+        while(i + step <= limit[i]) {
+            if(!tryRun(i + step)) { hi = i + step; break; }
+            lo = i + step;
+            step *= 2;
+        }
+        if(hi > limit[i] && lo < limit[i]) {
+            if(tryRun(limit[i])) lo = limit[i];
+            hi = limit[i];
+        }
+        while(hi - lo > 1) {
+            size_t mid = (lo + hi) / 2;
+            if(tryRun(mid)) lo = mid;
+            else hi = mid;
+        }
+
+        if(!best) {
+            push(segments, makeLine(p[i], p[i+1]));
+            i++;
+            continue;
+        }
+
+        push(segments, b1);
+        push(segments, b2);
+        i = best;
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef BIARC_H
+#define BIARC_H
+
+#include "clipper.h"
+
+#include <vector>
+
+using namespace ClipperLib;
+
+struct sArcSegment
+{
+    double x0, y0, x1, y1; // start and end point
+    double cx, cy, r;      // center and radius, unused for lines
+    int dir;               // 0 line, 1 counter clockwise, -1 clockwise
+};
+
+// fits tangent continuous arc pairs to a closed outline so that every vertex
+// and edge midpoint stays within tolerance, sharp corners are kept as corners,
+// clipper units are multiplied by scale
+void fitBiarcs(const Path& poly, double scale, double tolerance, std::vector<sArcSegment>& segments);
+
+#endif // BIARC_H
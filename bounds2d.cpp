@@ -13,11 +13,12 @@ void Bounds2D::init()
 
 void Bounds2D::add(QVector2D p)
 {
+    // no else, the first point has to set both ends
     if(p.x() < minX) minX = p.x();
-    else if(p.x() > maxX) maxX = p.x();
+    if(p.x() > maxX) maxX = p.x();
 
     if(p.y() < minY) minY = p.y();
-    else if(p.y() > maxY) maxY = p.y();
+    if(p.y() > maxY) maxY = p.y();
 }
 
 Bounds2D& Bounds2D::operator|=(const Bounds2D& rhs)
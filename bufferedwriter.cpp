@@ -0,0 +1,157 @@
+#include "bufferedwriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+static const int maxDecimals = 9;
+
+static thread_local const std::atomic<bool>* cancelFlag = nullptr;
+
+static bool cancelled()
+{
+    return cancelFlag && cancelFlag->load(std::memory_order_relaxed);
+}
+
+void cBufferedWriter::setCancelFlag(const std::atomic<bool>* cancel)
+{
+    cancelFlag = cancel;
+}
+
+cBufferedWriter::cBufferedWriter(size_t capacity) : mBuffer(capacity)
+{
+
+}
+
+// a writer destroyed without close() discards its temporary file
+bool cBufferedWriter::open(const QString& fname)
+{
+    if(mFile.isOpen()) {
+        mFile.cancelWriting();
+        mFile.commit();
+    }
+    mFile.setFileName(fname);
+    mOk = !cancelled() && mFile.open(QIODevice::WriteOnly);
+    mUsed = 0;
+    return mOk;
+}
+
+bool cBufferedWriter::close()
+{
+    if(!mFile.isOpen()) return mOk;
+    flush();
+    if(!mOk) {
+        mFile.cancelWriting();
+        mFile.commit();
+        return false;
+    }
+    mOk = mFile.commit();
+    return mOk;
+}
+
+void cBufferedWriter::flush()
+{
+    if(mOk && cancelled()) mOk = false;
+    if(mUsed && mOk)
+        mOk = mFile.write(mBuffer.data(), mUsed) == qint64(mUsed);
+    mUsed = 0;
+}
+
+char* cBufferedWriter::reserve(size_t size)
+{
+    if(mUsed + size > mBuffer.size()) {
+        flush();
+        if(size > mBuffer.size()) mBuffer.resize(size);
+    }
+    return mBuffer.data() + mUsed;
+}
+
+void cBufferedWriter::write(const char* data, size_t size)
+{
+    // big blocks go straight to the file
+    if(size > mBuffer.size() / 2) {
+        flush();
+        if(mOk) mOk = mFile.write(data, qint64(size)) == qint64(size);
+        return;
+    }
+    memcpy(reserve(size), data, size);
+    mUsed += size;
+}
+
+void cBufferedWriter::write(const char* str)
+{
+    write(str, strlen(str));
+}
+
+void cBufferedWriter::write(const QByteArray& data)
+{
+    write(data.constData(), size_t(data.size()));
+}
+
+void cBufferedWriter::writeInt(long long v)
+{
+    char* p = reserve(24);
+    char* start = p;
+    unsigned long long u = v < 0 ? 0ull - (unsigned long long)v : (unsigned long long)v;
+    if(v < 0) *p++ = '-';
+
+    char tmp[24];
+    int len = 0;
+    do { tmp[len++] = char('0' + u % 10); u /= 10; } while(u);
+    while(len) *p++ = tmp[--len];
+
+    mUsed += p - start;
+}
+
+void cBufferedWriter::writeHex(unsigned long long v, int minDigits)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    char* p = reserve(32);
+
+    char tmp[16];
+    int len = 0;
+    do { tmp[len++] = digits[v & 15]; v >>= 4; } while(v);
+
+    int pad = std::min(std::max(minDigits - len, 0), 16);
+    for(int i=0; i<pad; i++) p[i] = '0';
+    for(int i=0; i<len; i++) p[pad + i] = tmp[len - 1 - i];
+
+    mUsed += pad + len;
+}
+
+void cBufferedWriter::writeFixed(double v, int decimals)
+{
+    if(!std::isfinite(v)) v = 0.0;
+    decimals = std::min(std::max(decimals, 0), maxDecimals);
+
+    double scaled = std::round(std::fabs(v) * powersOf10[decimals]);
+    if(scaled >= 9e18) {
+        // out of the integer range, not a coordinate anyway
+        char* p = reserve(512);
+        mUsed += snprintf(p, 512, "%.*f", decimals, v);
+        return;
+    }
+
+    unsigned long long n = (unsigned long long)scaled;
+    unsigned long long div = (unsigned long long)powersOf10[decimals];
+    unsigned long long ip = n / div, fp = n % div;
+
+    char* p = reserve(48);
+    char* start = p;
+    if(v < 0 && n) *p++ = '-';
+
+    char tmp[24];
+    int len = 0;
+    do { tmp[len++] = char('0' + ip % 10); ip /= 10; } while(ip);
+    while(len) *p++ = tmp[--len];
+
+    if(decimals) {
+        *p++ = '.';
+        for(int i=decimals-1; i>=0; i--) { p[i] = char('0' + fp % 10); fp /= 10; }
+        p += decimals;
+    }
+
+    mUsed += p - start;
+}
@@ -0,0 +1,43 @@
+#ifndef BUFFEREDWRITER_H
+#define BUFFEREDWRITER_H
+
+#include <QSaveFile>
+#include <QByteArray>
+#include <QString>
+
+#include <atomic>
+#include <vector>
+
+// opens the file once and formats straight into a reusable buffer that is
+// flushed in big chunks, used by the exporters instead of QString + appendFile.
+// The data goes to a temporary file that replaces the target on close, so an
+// unfinished or cancelled export never leaves a partial file behind.
+class cBufferedWriter
+{
+public:
+    explicit cBufferedWriter(size_t capacity = 1 << 20);
+
+    bool open(const QString& fname);
+    bool close(); // flushes and commits, false if any write failed or it was cancelled
+
+    // writers on the calling thread give up once the flag is set
+    static void setCancelFlag(const std::atomic<bool>* cancel);
+
+    void write(const char* data, size_t size);
+    void write(const char* str);
+    void write(const QByteArray& data);
+    void writeInt(long long v);
+    void writeHex(unsigned long long v, int minDigits = 1); // upper case, zero padded
+    void writeFixed(double v, int decimals = 6); // like "%.6f"
+
+private:
+    char* reserve(size_t size);
+    void flush();
+
+    QSaveFile mFile;
+    std::vector<char> mBuffer;
+    size_t mUsed = 0;
+    bool mOk = false;
+};
+
+#endif // BUFFEREDWRITER_H
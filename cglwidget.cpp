@@ -12,6 +12,10 @@
 #include <QTimer>
 #include "utils.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
 cGLWidget::cGLWidget(QWidget *parent) :
     QOpenGLWidget(parent), mEye(QVector3D(0,0,700)), mView(QVector3D(0,0,0)), mUp(QVector3D(0,1,0))
 {
@@ -20,7 +24,23 @@ cGLWidget::cGLWidget(QWidget *parent) :
     mTimer = new QTimer(this);
     mTimer->setObjectName("mTimer");
     connect(mTimer, SIGNAL(timeout()), this, SLOT(on_mTimer_timeout()));
-    mTimer->start(10);
+    mTimer->setInterval(10); // only runs while a movement key is held
+}
+
+// QOpenGLBuffer has no uniform buffer type, the camera block is a plain GL
+// buffer and is deleted by hand in the context it was created in
+cGLWidget::~cGLWidget()
+{
+    if(!mCameraUBO) return;
+
+    if(mOffscreenContext) mOffscreenContext->makeCurrent(mOffscreenSurface);
+    else makeCurrent();
+
+    glDeleteBuffers(1, &mCameraUBO);
+    mCameraUBO = 0;
+
+    if(mOffscreenContext) mOffscreenContext->doneCurrent();
+    else doneCurrent();
 }
 
 float cGLWidget::scale(float from_min, float from_max, float to_min, float to_max, float val)
@@ -140,6 +160,13 @@ void cGLWidget::initializeGL()
 {
     initializeOpenGLFunctions();
 
+    mGL = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_4_3_Core>();
+    if(!mGL || !mGL->initializeOpenGLFunctions()) {
+        qDebug() << "OpenGL 4.3 core functions are not available";
+        close();
+        return;
+    }
+
     glClearColor(0.2f, 0.6f, 0.2f, 1.f);
 
     qDebug() << "Supported shading language version"  << QString((char*)glGetString(GL_VENDOR))<< QString((char*)glGetString(GL_RENDERER)) << QString((char*)glGetString(GL_VERSION)) /*<< QString((char*)glGetString(GL_EXTENSIONS))*/ << QString((char*)glGetString(GL_SHADING_LANGUAGE_VERSION));
@@ -164,9 +191,119 @@ void cGLWidget::initializeGL()
     mVAO.create();
     QOpenGLVertexArrayObject::Binder vaoBinder(&mVAO);
 
+    // the camera block every shader reads, filled once per frame
+    glGenBuffers(1, &mCameraUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, mCameraUBO);
+    glBufferData(GL_UNIFORM_BUFFER, 2 * 16 * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    mGL->glBindBufferBase(GL_UNIFORM_BUFFER, cameraBinding, mCameraUBO);
+
+    initMarkerMesh();
+    initGrid();
+
     emit(glInitialized());
 }
 
+static const float gridZ = -2.5f;
+
+// square grids of 10, 100 and 1000 units below the drawing plane, each
+// level is a range in one static buffer, the zoom level picks what shows
+void cGLWidget::initGrid()
+{
+    const float spacing[gridLevels] = { 10.f, 100.f, 1000.f };
+    const float extent[gridLevels] = { 2000.f, 2000.f, 10000.f };
+
+    std::vector<sVertex> grid;
+    sVertex v;
+    v.color[0] = 153; v.color[1] = 51; v.color[2] = 51; v.color[3] = 255;
+
+    for(int l=0; l<gridLevels; l++) {
+        mGridFirst[l] = int(grid.size());
+        mGridSpacing[l] = spacing[l];
+        int n = int(extent[l] / spacing[l]);
+        for(int i=-n; i<=n; i++) {
+            float c = i * spacing[l];
+            v.x = c; v.y = -extent[l]; grid.push_back(v);
+            v.x = c; v.y = extent[l]; grid.push_back(v);
+            v.x = -extent[l]; v.y = c; grid.push_back(v);
+            v.x = extent[l]; v.y = c; grid.push_back(v);
+        }
+        mGridCount[l] = int(grid.size()) - mGridFirst[l];
+    }
+
+    mGrid = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+    mGrid.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    mGrid.create();
+    mGrid.bind();
+    mGrid.allocate(grid.data(), int(grid.size() * sizeof(sVertex)));
+    mGrid.release();
+}
+
+// the width of the drawing plane the camera sees, roughly
+float cGLWidget::visibleExtent()
+{
+    if(!mPerspectiveProjection) {
+        float aspect = float(renderSize().width()) / std::max(renderSize().height(), 1);
+        return 1024.f * std::max(aspect, 1.f); // see the ortho box in updateProjection
+    }
+    QVector3D eyeDir = (mView - mEye).normalized();
+    float dist = std::fabs(mEye.z()) / std::max(std::fabs(eyeDir.z()), 0.1f);
+    return 2.f * dist * std::tan(d2r(45.f / 2));
+}
+
+// levels with too many lines on screen fade out, the coarser ones stay
+void cGLWidget::drawGrid()
+{
+    if(!mGrid.isCreated()) return;
+
+    mGrid.bind();
+    setVertexFormat();
+    mGrid.release();
+
+    setZ(gridZ);
+
+    float extent = visibleExtent();
+    for(int l=0; l<gridLevels; l++) {
+        float lines = extent / mGridSpacing[l];
+        float alpha = qBound(0.f, (100.f - lines) / 50.f, 1.f);
+        if(alpha <= 0.f) continue;
+        glVertexAttrib4f(3, 1.f, 1.f, 1.f, alpha);
+        glDrawArrays(GL_LINES, mGridFirst[l], mGridCount[l]);
+    }
+    glVertexAttrib4f(3, 1.f, 1.f, 1.f, 1.f);
+}
+
+// three rings, black, yellow and black, drawn as line pairs so one
+// instanced GL_LINES call covers every marker
+void cGLWidget::initMarkerMesh()
+{
+    const int sections = 36;
+    const float radii[3] = { 2.f, 2.5f, 3.f };
+    const GLubyte colors[3][4] = { { 0, 0, 0, 255 }, { 255, 204, 0, 255 }, { 0, 0, 0, 255 } };
+
+    std::vector<sVertex> mesh;
+    for(int r=0; r<3; r++) {
+        for(int i=0; i<sections; i++) {
+            for(int k=0; k<2; k++) {
+                float phi = d2r(360.f * (i + k) / sections);
+                sVertex v;
+                v.x = sin(phi) * radii[r];
+                v.y = cos(phi) * radii[r];
+                memcpy(v.color, colors[r], sizeof(v.color));
+                mesh.push_back(v);
+            }
+        }
+    }
+
+    mMarkerMesh = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+    mMarkerMesh.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    mMarkerMesh.create();
+    mMarkerMesh.bind();
+    mMarkerMesh.allocate(mesh.data(), int(mesh.size() * sizeof(sVertex)));
+    mMarkerMesh.release();
+    mMarkerMeshSize = int(mesh.size());
+}
+
 void cGLWidget::initShaders()
 {
     // Overriding system locale until shaders are compiled
@@ -188,6 +325,9 @@ void cGLWidget::initShaders()
     if (!mShader.link())
         close();
 
+    mZLocation = mShader.uniformLocation("qt_z");
+    mPlaceLocation = mShader.uniformLocation("qt_place");
+
     // Binding shader pipeline for use
     if (!mShader.bind())
         close();
@@ -198,52 +338,223 @@ void cGLWidget::initShaders()
     setlocale(LC_ALL, "");
 }
 
+// GL_LINES and the like simply grow one range, strips and loops get a range each
+static bool independentPrimitives(int mode)
+{
+    return mode == GL_POINTS || mode == GL_LINES || mode == GL_TRIANGLES;
+}
+
+static void addToBatches(std::vector<sBatch>& batches, const std::vector<GLfloat>& buffer, int mode, const QVector4D& color, float z)
+{
+    auto it = std::find_if(batches.begin(), batches.end(), [mode, z](const sBatch& b) { return b.mode == mode && b.z == z; });
+    if(it == batches.end()) {
+        batches.push_back(sBatch());
+        batches.back().mode = mode;
+        batches.back().z = z;
+        it = batches.end() - 1;
+    }
+    sBatch& b = *it;
+
+    sVertex v;
+    for(int i=0; i<4; i++)
+        v.color[i] = static_cast<GLubyte>(qBound(0.f, color[i], 1.f) * 255.f + 0.5f);
+
+    GLint first = GLint(b.vertices.size());
+    GLsizei count = GLsizei(buffer.size() / 2);
+    for(size_t i=0; i+1<buffer.size(); i+=2) {
+        v.x = buffer[i];
+        v.y = buffer[i+1];
+        b.vertices.push_back(v);
+    }
+
+    if(independentPrimitives(mode) && b.counts.size()) {
+        b.counts.back() += count;
+    } else {
+        b.firsts.push_back(first);
+        b.counts.push_back(count);
+    }
+}
+
+// every change to the geometry schedules a repaint, nothing is drawn otherwise
 void cGLWidget::clearVBOs()
 {
-    mVBOs.clear();
+    mBatches.clear();
+    mSceneDirty = true;
+    mMarkers.clear();
+    mMarkersDirty = true;
+    mText.clear();
+    mTextDirty = true;
+    mOutlines.clear();
+    mOutlinesDirty = true;
+    update();
 }
 
-void cGLWidget::destroyVBO(const QString &name)
+// chunks and levels of the loop, the placement of o is left alone
+bool cGLWidget::compileOutline(const std::vector<GLfloat>& loop, QVector4D color, float z, sOutline& o)
 {
-    if(mNamedVBOs.contains(name))
-        mNamedVBOs[name].vbo.destroy();
+    if(loop.size() < 4) return false;
+
+    o.z = z;
+    o.chunks.clear();
+    mOutlineScratch.clear();
+    buildOutlineLods(loop, mOutlineScratch, o.chunks);
+
+    sVertex v;
+    for(int i=0; i<4; i++)
+        v.color[i] = static_cast<GLubyte>(qBound(0.f, color[i], 1.f) * 255.f + 0.5f);
+    o.vertices.clear();
+    o.vertices.reserve(mOutlineScratch.size());
+    for(auto& p : mOutlineScratch) {
+        v.x = p.x();
+        v.y = p.y();
+        o.vertices.push_back(v);
+    }
+    return true;
+}
 
-    mNamedVBOs.remove(name);
+void cGLWidget::addOutline(const std::vector<GLfloat>& loop, QVector4D color, float z)
+{
+    mOutlines.push_back(sOutline());
+    if(!compileOutline(loop, color, z, mOutlines.back())) {
+        mOutlines.pop_back();
+        return;
+    }
+    mOutlinesDirty = true;
+    update();
 }
 
-void cGLWidget::addToVBO(const QString& name, const std::vector<GLfloat> &buffer, int mode, QVector4D lineColor)
+void cGLWidget::addOutline(const QString& name, const std::vector<GLfloat>& loop, QVector4D color, float z)
 {
-    if(!buffer.size()) return;
+    if(!compileOutline(loop, color, z, mNamedOutlines[name])) {
+        mNamedOutlines.remove(name);
+        return;
+    }
+    mNamedOutlinesDirty = true;
+    update();
+}
 
-    if(mNamedVBOs.contains(name))
-        mNamedVBOs[name].vbo.destroy();
+void cGLWidget::placeOutline(const QString& name, float angle, QVector2D offset)
+{
+    auto it = mNamedOutlines.find(name);
+    if(it == mNamedOutlines.end()) return;
 
-    sBufferWithColor b;
-    b.mode = mode;
-    b.lineColor = lineColor;
-    b.vbo.create();
-    b.vbo.bind();
-    b.vbo.allocate(buffer.data(), buffer.size() * sizeof(GLfloat));
-    b.vbo.release();
+    it->co = std::cos(angle);
+    it->si = std::sin(angle);
+    it->offset = offset;
+    update();
+}
+
+void cGLWidget::setGlyphs(SVG& font)
+{
+    mGlyphVertices.clear();
+
+    sVertex v;
+    memset(v.color, 255, sizeof(v.color));
+
+    for(int g=0; g<glyphs; g++) {
+        mGlyphFirst[g] = int(mGlyphVertices.size());
+        mGlyphAdvance[g] = 0.f;
+        if(font.mPoints.contains(g)) {
+            Character& chr = font.mPoints[g];
+            for(auto& poly : chr) {
+                for(size_t i=0; i<poly.size(); i++) {
+                    size_t j = i+1; if(j==poly.size()) j=0;
+                    v.x = poly[i].x(); v.y = poly[i].y(); mGlyphVertices.push_back(v);
+                    v.x = poly[j].x(); v.y = poly[j].y(); mGlyphVertices.push_back(v);
+                }
+            }
+            mGlyphAdvance[g] = chr.width();
+        }
+        mGlyphCount[g] = int(mGlyphVertices.size()) - mGlyphFirst[g];
+    }
+
+    mGlyphsDirty = true;
+    update();
+}
+
+float cGLWidget::compileText(const QString& text, QVector2D pos, QVector4D color, std::vector<sGlyphInstance>& res)
+{
+    sGlyphInstance gi;
+    for(int i=0; i<4; i++)
+        gi.instance.color[i] = static_cast<GLubyte>(qBound(0.f, color[i], 1.f) * 255.f + 0.5f);
+
+    float xOffs = 0.f;
+    for(int i=0; i<text.size(); i++) {
+        gi.glyph = static_cast<unsigned char>(text[i].toLatin1());
+        gi.instance.x = pos.x() + xOffs;
+        gi.instance.y = pos.y();
+        if(mGlyphCount[gi.glyph]) res.push_back(gi);
+        xOffs += mGlyphAdvance[gi.glyph];
+    }
+    return xOffs;
+}
+
+float cGLWidget::addText(const QString& text, QVector2D pos, QVector4D color)
+{
+    mTextDirty = true;
+    update();
+    return compileText(text, pos, color, mText);
+}
+
+float cGLWidget::addText(const QString& name, const QString& text, QVector2D pos, QVector4D color)
+{
+    std::vector<sGlyphInstance>& res = mNamedText[name];
+    res.clear();
+    mTextDirty = true;
+    update();
+    return compileText(text, pos, color, res);
+}
+
+void cGLWidget::addMarker(QVector2D pos, QVector4D color)
+{
+    sInstance m;
+    m.x = pos.x();
+    m.y = pos.y();
+    for(int i=0; i<4; i++)
+        m.color[i] = static_cast<GLubyte>(qBound(0.f, color[i], 1.f) * 255.f + 0.5f);
+    mMarkers.push_back(m);
+    mMarkersDirty = true;
+    update();
+}
 
-    if(mNamedVBOs.contains(name))
-        mNamedVBOs[name] = b;
-    else
-        mNamedVBOs.insert(name, b);
+void cGLWidget::destroyVBO(const QString &name)
+{
+    if(mNamedVBOs.remove(name)) {
+        mNamedDirty = true;
+        update();
+    }
+    if(mNamedText.remove(name)) {
+        mTextDirty = true;
+        update();
+    }
+    if(mNamedOutlines.remove(name)) {
+        mNamedOutlinesDirty = true;
+        update();
+    }
 }
 
-void cGLWidget::addToVBO(const std::vector<GLfloat> &buffer, int mode, QVector4D lineColor)
+void cGLWidget::addToVBO(const QString& name, const std::vector<GLfloat> &buffer, int mode, QVector4D lineColor, float z)
 {
     if(!buffer.size()) return;
 
     sBufferWithColor b;
     b.mode = mode;
     b.lineColor = lineColor;
-    b.vbo.create();
-    b.vbo.bind();
-    b.vbo.allocate(buffer.data(), buffer.size() * sizeof(GLfloat));
-    b.vbo.release();
-    mVBOs.push_back(b);
+    b.z = z;
+    b.vertices = buffer;
+
+    mNamedVBOs[name] = b;
+    mNamedDirty = true;
+    update();
+}
+
+void cGLWidget::addToVBO(const std::vector<GLfloat> &buffer, int mode, QVector4D lineColor, float z)
+{
+    if(!buffer.size()) return;
+
+    addToBatches(mBatches, buffer, mode, lineColor, z);
+    mSceneDirty = true;
+    update();
 }
 
 void cGLWidget::topView()
@@ -292,7 +603,7 @@ void cGLWidget::resizeGL(int w, int h)
 
 void cGLWidget::updateProjection(bool perspectiveProjection)
 {
-    float w=width(), h=height();
+    float w=renderSize().width(), h=renderSize().height();
 
     float aspect = w / h;
 
@@ -310,6 +621,102 @@ void cGLWidget::updateProjection(bool perspectiveProjection)
         mOrthoProjectionMatrix = mProjectionMatrix;
     }
     mPerspectiveProjection = perspectiveProjection;
+    update();
+}
+
+QSize cGLWidget::renderSize() const
+{
+    return mRenderSize.isEmpty() ? size() : mRenderSize;
+}
+
+// QOffscreenSurface is a pbuffer or, where EGL allows it, no surface at all,
+// so this runs on a build box without a display
+bool cGLWidget::initializeOffscreen()
+{
+    if(context() || mOffscreenContext) return mGL != nullptr;
+
+    mOffscreenSurface = new QOffscreenSurface(nullptr, this);
+    mOffscreenSurface->setFormat(QSurfaceFormat::defaultFormat());
+    mOffscreenSurface->create();
+
+    mOffscreenContext = new QOpenGLContext(this);
+    mOffscreenContext->setFormat(QSurfaceFormat::defaultFormat());
+    if(!mOffscreenSurface->isValid() || !mOffscreenContext->create() || !mOffscreenContext->makeCurrent(mOffscreenSurface)) {
+        qDebug() << "Could not create an offscreen OpenGL context";
+        return false;
+    }
+
+    initializeGL();
+    mOffscreenContext->doneCurrent();
+    return mGL != nullptr;
+}
+
+void cGLWidget::frameScene(QSize size)
+{
+    Bounds2D b;
+    for(auto& o : mOutlines)
+        for(auto& c : o.chunks) b |= c.bounds;
+    for(auto& o : mNamedOutlines) {
+        for(auto& c : o.chunks) {
+            for(float x : { c.bounds.minX, c.bounds.maxX })
+                for(float y : { c.bounds.minY, c.bounds.maxY })
+                    b.add(QVector2D(o.co * x - o.si * y, o.si * x + o.co * y) + o.offset);
+        }
+    }
+    for(auto& batch : mBatches)
+        for(auto& v : batch.vertices) b.add(QVector2D(v.x, v.y));
+    for(auto& m : mMarkers) b.add(QVector2D(m.x, m.y));
+    if(b.minX > b.maxX) return;
+
+    // half the visible height with a 10% margin, wide scenes are fit by width
+    float aspect = float(size.width()) / std::max(size.height(), 1);
+    float half = std::max(b.maxY - b.minY, (b.maxX - b.minX) / aspect) * 0.55f;
+
+    mView = QVector3D((b.minX + b.maxX) / 2, (b.minY + b.maxY) / 2, 0.f);
+    mEye = mView + QVector3D(0, 0, half / std::tan(d2r(45.f / 2)));
+    mUp = QVector3D(0,1,0);
+
+    update();
+}
+
+QImage cGLWidget::renderImage(QSize size)
+{
+    if(mOffscreenContext) {
+        if(!mOffscreenContext->makeCurrent(mOffscreenSurface)) return QImage();
+    } else if(context()) {
+        makeCurrent();
+    } else {
+        return QImage();
+    }
+
+    QImage image;
+
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+    format.setSamples(QSurfaceFormat::defaultFormat().samples());
+    QOpenGLFramebufferObject fbo(size, format);
+
+    if(fbo.isValid() && fbo.bind()) {
+        mRenderSize = size;
+        updateProjection(mPerspectiveProjection);
+        glViewport(0, 0, size.width(), size.height());
+
+        paintGL();
+
+        // resolves the samples first if there are any
+        image = fbo.toImage();
+        fbo.release();
+
+        mRenderSize = QSize();
+        updateProjection(mPerspectiveProjection);
+    } else {
+        qDebug() << "Could not create a framebuffer of" << size;
+    }
+
+    if(mOffscreenContext) mOffscreenContext->doneCurrent();
+    else doneCurrent();
+
+    return image;
 }
 
 void cGLWidget::paintGL()
@@ -318,56 +725,289 @@ void cGLWidget::paintGL()
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
 
-    QOpenGLContext *ctx = QOpenGLContext::currentContext();
-
     QOpenGLVertexArrayObject::Binder vaoBinder(&mVAO);
 
-    QOpenGLFunctions *f=nullptr;
     QMatrix4x4 viewMatrix, modelMatrix, lightViewMatrix;
 
     modelMatrix.setToIdentity();
 
     viewMatrix.lookAt(mEye, mView, mUp);
 
-    for(auto& b : mVBOs) {
-        b.vbo.bind();
-        mShader.bind();
+    // the named buffers are few and small, they are rebatched as a whole
+    bool namedDirty = mNamedDirty;
+    if(mNamedDirty) {
+        mNamedBatches.clear();
+        for(auto& b : mNamedVBOs)
+            addToBatches(mNamedBatches, b.vertices, b.mode, b.lineColor, b.z);
+        mNamedDirty = false;
+    }
+
+    // std140 lays a mat4 out as four vec4 columns, just like QMatrix4x4
+    glBindBuffer(GL_UNIFORM_BUFFER, mCameraUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, 16 * sizeof(GLfloat), viewMatrix.constData());
+    glBufferSubData(GL_UNIFORM_BUFFER, 16 * sizeof(GLfloat), 16 * sizeof(GLfloat), mProjectionMatrix.constData());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    mShader.bind();
+
+    // plain batches have no instance arrays, they read these constants
+    glVertexAttrib2f(2, 0.f, 0.f);
+    glVertexAttrib4f(3, 1.f, 1.f, 1.f, 1.f);
+    setPlacement(1.f, 0.f, QVector2D());
 
-        mShader.setUniformValue("qt_lineColor", b.lineColor);
-        mShader.setUniformValue("qt_modelViewMatrix", viewMatrix);
-        mShader.setUniformValue("qt_projectionMatrix", mProjectionMatrix);
+    drawGrid();
 
-        f = ctx->functions();
-        f->glEnableVertexAttribArray(0);
+    drawBatches(mScenePool, mBatches, mSceneDirty);
+    drawBatches(mNamedPool, mNamedBatches, namedDirty);
+    mSceneDirty = false;
 
-        f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-        glDrawArrays(b.mode, 0, b.vbo.size() / 3 / sizeof(GLfloat));
+    drawOutlines(viewMatrix);
 
-        mShader.release();
-        b.vbo.release();
+    drawMarkers();
+    drawText();
+
+    mShader.release();
+}
+
+// true if the box at height z is completely on the outer side of one of the
+// six clip planes
+static bool outsideView(const QMatrix4x4& mvp, const Bounds2D& b, float z)
+{
+    const QVector4D corners[4] = {
+        mvp * QVector4D(b.minX, b.minY, z, 1.f),
+        mvp * QVector4D(b.maxX, b.minY, z, 1.f),
+        mvp * QVector4D(b.minX, b.maxY, z, 1.f),
+        mvp * QVector4D(b.maxX, b.maxY, z, 1.f)
+    };
+
+    for(int axis=0; axis<3; axis++) {
+        for(int side=-1; side<=1; side+=2) {
+            int out = 0;
+            for(auto& c : corners)
+                if(side * c[axis] > c.w()) out++;
+            if(out == 4) return true;
+        }
     }
+    return false;
+}
 
-    // draw named vbos
-    for(auto k: mNamedVBOs.keys())
-    {
-        sBufferWithColor& b = mNamedVBOs[k];
-        b.vbo.bind();
-        mShader.bind();
+// chunks out of view are skipped, the rest draw the coarsest level whose
+// error stays below half a pixel, all strips of an outline in one call. The
+// chunk boxes are in the outline's own frame, so the culling goes through
+// its placement and the eye is taken into that frame for the distance
+void cGLWidget::drawOutline(const sOutline& o, const QMatrix4x4& viewProjection, float pixel)
+{
+    QMatrix4x4 model(o.co, -o.si, 0.f, o.offset.x(),
+                     o.si,  o.co, 0.f, o.offset.y(),
+                     0.f,   0.f,  1.f, 0.f,
+                     0.f,   0.f,  0.f, 1.f);
+    QMatrix4x4 mvp = viewProjection * model;
+
+    float ex = mEye.x() - o.offset.x(), ey = mEye.y() - o.offset.y();
+    QVector3D eye(o.co * ex + o.si * ey, o.co * ey - o.si * ex, mEye.z());
+
+    mFirsts.clear();
+    mCounts.clear();
+
+    for(auto& c : o.chunks) {
+        if(outsideView(mvp, c.bounds, o.z)) continue;
+
+        float size = pixel;
+        if(mPerspectiveProjection) {
+            QVector3D nearest(qBound(c.bounds.minX, eye.x(), c.bounds.maxX), qBound(c.bounds.minY, eye.y(), c.bounds.maxY), o.z);
+            size *= (nearest - eye).length();
+        }
+
+        int l = 0;
+        while(l+1 < outlineLevels && outlineTolerance[l+1] <= 0.5f * size) l++;
+
+        mFirsts.push_back(o.base + c.first[l]);
+        mCounts.push_back(c.count[l]);
+    }
+
+    if(mFirsts.empty()) return;
+
+    setZ(o.z);
+    setPlacement(o.co, o.si, o.offset);
+    mGL->glMultiDrawArrays(GL_LINE_STRIP, mFirsts.data(), mCounts.data(), GLsizei(mFirsts.size()));
+}
+
+// the scene outlines and the named ones have a pool each, so replacing a
+// named outline does not upload the scene again
+void cGLWidget::drawOutlines(const QMatrix4x4& viewMatrix)
+{
+    if(mOutlinesDirty) {
+        mOutlinePool.clear();
+        for(auto& o : mOutlines)
+            o.base = mOutlinePool.add(o.vertices.data(), int(o.vertices.size() * sizeof(sVertex))) / int(sizeof(sVertex));
+        mOutlinesDirty = false;
+    }
+    if(mNamedOutlinesDirty) {
+        mNamedOutlinePool.clear();
+        for(auto& o : mNamedOutlines)
+            o.base = mNamedOutlinePool.add(o.vertices.data(), int(o.vertices.size() * sizeof(sVertex))) / int(sizeof(sVertex));
+        mNamedOutlinesDirty = false;
+    }
+
+    QMatrix4x4 viewProjection = mProjectionMatrix * viewMatrix;
+
+    // element (1,1) is 2/height of the ortho box, or cot(fov/2) for the
+    // perspective where the pixel size also grows with the distance
+    float pixel = 2.f / (mProjectionMatrix(1, 1) * std::max(renderSize().height(), 1));
+
+    if(!mOutlines.empty() && mOutlinePool.bind()) {
+        setVertexFormat();
+        for(auto& o : mOutlines) drawOutline(o, viewProjection, pixel);
+        mOutlinePool.release();
+    }
+
+    if(!mNamedOutlines.empty() && mNamedOutlinePool.bind()) {
+        setVertexFormat();
+        for(auto& o : mNamedOutlines) drawOutline(o, viewProjection, pixel);
+        mNamedOutlinePool.release();
+    }
+
+    setPlacement(1.f, 0.f, QVector2D());
+}
+
+void cGLWidget::drawText()
+{
+    if(mGlyphsDirty) {
+        if(!mGlyphBuffer.isCreated()) {
+            mGlyphBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+            mGlyphBuffer.create();
+        }
+        mGlyphBuffer.bind();
+        mGlyphBuffer.allocate(mGlyphVertices.data(), int(mGlyphVertices.size() * sizeof(sVertex)));
+        mGlyphBuffer.release();
+        mGlyphsDirty = false;
+    }
+
+    // the instances sorted by glyph, so each glyph draws a contiguous run
+    if(mTextDirty) {
+        std::fill(mTextInstances, mTextInstances + glyphs, 0);
+        for(auto& gi : mText) mTextInstances[gi.glyph]++;
+        for(auto& t : mNamedText)
+            for(auto& gi : t) mTextInstances[gi.glyph]++;
+
+        int total = 0;
+        for(int g=0; g<glyphs; g++) {
+            mTextBase[g] = total;
+            total += mTextInstances[g];
+        }
+
+        std::vector<sInstance>& sorted = mTextScratch;
+        sorted.resize(size_t(total));
+        std::vector<int> next(mTextBase, mTextBase + glyphs);
+        for(auto& gi : mText) sorted[size_t(next[gi.glyph]++)] = gi.instance;
+        for(auto& t : mNamedText)
+            for(auto& gi : t) sorted[size_t(next[gi.glyph]++)] = gi.instance;
+
+        mTextPool.clear();
+        mTextPool.add(sorted.data(), int(sorted.size() * sizeof(sInstance)));
+        mTextDirty = false;
+    }
+
+    if(!mGlyphBuffer.isCreated() || !mTextPool.bind()) return;
+
+    setInstanceFormat();
+    mTextPool.release();
+
+    mGlyphBuffer.bind();
+    setVertexFormat();
+    mGlyphBuffer.release();
+
+    setZ(0.f);
+    for(int g=0; g<glyphs; g++) {
+        if(!mTextInstances[g]) continue;
+        mGL->glDrawArraysInstancedBaseInstance(GL_LINES, mGlyphFirst[g], mGlyphCount[g], mTextInstances[g], GLuint(mTextBase[g]));
+    }
+
+    glDisableVertexAttribArray(2);
+    glDisableVertexAttribArray(3);
+}
+
+void cGLWidget::drawMarkers()
+{
+    if(mMarkersDirty) {
+        mMarkerPool.clear();
+        mMarkerPool.add(mMarkers.data(), int(mMarkers.size() * sizeof(sInstance)));
+        mMarkersDirty = false;
+    }
+
+    if(mMarkers.empty() || !mMarkerMesh.isCreated() || !mMarkerPool.bind()) return;
+
+    setInstanceFormat();
+    mMarkerPool.release();
+
+    mMarkerMesh.bind();
+    setVertexFormat();
+    mMarkerMesh.release();
+
+    setZ(0.5f);
+    mGL->glDrawArraysInstanced(GL_LINES, 0, mMarkerMeshSize, GLsizei(mMarkers.size()));
+
+    glDisableVertexAttribArray(2);
+    glDisableVertexAttribArray(3);
+}
+
+// x,y and colour from the buffer bound right now, z comes from setZ
+void cGLWidget::setVertexFormat()
+{
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(sVertex), reinterpret_cast<void*>(offsetof(sVertex, x)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(sVertex), reinterpret_cast<void*>(offsetof(sVertex, color)));
+}
 
-        mShader.setUniformValue("qt_lineColor", b.lineColor);
-        mShader.setUniformValue("qt_modelViewMatrix", viewMatrix);
-        mShader.setUniformValue("qt_projectionMatrix", mProjectionMatrix);
+void cGLWidget::setInstanceFormat()
+{
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(sInstance), reinterpret_cast<void*>(offsetof(sInstance, x)));
+    mGL->glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(sInstance), reinterpret_cast<void*>(offsetof(sInstance, color)));
+    mGL->glVertexAttribDivisor(3, 1);
+}
 
-        f = ctx->functions();
-        f->glEnableVertexAttribArray(0);
+void cGLWidget::setZ(float z)
+{
+    mShader.setUniformValue(mZLocation, z);
+}
 
-        f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-        glDrawArrays(b.mode, 0, b.vbo.size() / 3 / sizeof(GLfloat));
+// cos and sin of the rotation and the offset after it, identity for all but
+// the named outlines
+void cGLWidget::setPlacement(float co, float si, QVector2D offset)
+{
+    mShader.setUniformValue(mPlaceLocation, QVector4D(co, si, offset.x(), offset.y()));
+}
 
-        mShader.release();
-        b.vbo.release();
+// one call per primitive mode, ranges of strips and loops go through glMultiDrawArrays
+void cGLWidget::drawBatches(cGLBufferPool& pool, std::vector<sBatch>& batches, bool restage)
+{
+    if(restage) {
+        pool.clear();
+        for(auto& b : batches)
+            b.base = pool.add(b.vertices.data(), int(b.vertices.size() * sizeof(sVertex))) / int(sizeof(sVertex));
     }
 
+    if(!pool.bind()) return;
+
+    setVertexFormat();
+
+    for(auto& b : batches) {
+        setZ(b.z);
+        if(b.counts.size() == 1) {
+            glDrawArrays(b.mode, b.base + b.firsts[0], b.counts[0]);
+            continue;
+        }
+        mFirsts.resize(b.firsts.size());
+        for(size_t i=0; i<b.firsts.size(); i++)
+            mFirsts[i] = b.base + b.firsts[i];
+        mGL->glMultiDrawArrays(b.mode, mFirsts.data(), b.counts.data(), GLsizei(b.counts.size()));
+    }
+
+    pool.release();
 }
 
 float cGLWidget::LinearizeDepth(float depth)
@@ -377,14 +1017,42 @@ float cGLWidget::LinearizeDepth(float depth)
     return (2.0f * zNear) / (zFar + zNear - depth * (zFar - zNear));
 }
 
+static bool isMovementKey(int key)
+{
+    return key == Qt::Key_W || key == Qt::Key_S || key == Qt::Key_A || key == Qt::Key_D || key == Qt::Key_Space;
+}
+
+bool cGLWidget::movementKeyDown()
+{
+    for(auto it = mKeyDown.begin(); it != mKeyDown.end(); ++it)
+        if(it.value() && isMovementKey(it.key())) return true;
+    return false;
+}
+
 void cGLWidget::keyPressEvent(QKeyEvent *ke)
 {
+    if(ke->isAutoRepeat()) return;
+
     mKeyDown[ke->key()] = true;
+    if(isMovementKey(ke->key()) && !mTimer->isActive())
+        mTimer->start();
 }
 
 void cGLWidget::keyReleaseEvent(QKeyEvent *ke)
 {
+    if(ke->isAutoRepeat()) return;
+
     mKeyDown[ke->key()] = false;
+    if(!movementKeyDown())
+        mTimer->stop();
+}
+
+// the release of a key held while the focus goes away never arrives
+void cGLWidget::focusOutEvent(QFocusEvent *fe)
+{
+    mKeyDown.clear();
+    mTimer->stop();
+    QOpenGLWidget::focusOutEvent(fe);
 }
 
 void cGLWidget::on_mTimer_timeout()
@@ -486,12 +1154,11 @@ void cGLWidget::mouseMoveEvent(QMouseEvent *me)
         update();
     }
 
+    // whatever the cursor changes in the scene comes back through addToVBO
     QVector3D pw;
     if(screenToWorld(me->x(), me->y(), -1.0, pw)) {
         Q_EMIT mouseMove(pw);
     }
-
-    update();
 }
 
 void cGLWidget::mousePressEvent(QMouseEvent *me)
@@ -509,8 +1176,6 @@ void cGLWidget::mousePressEvent(QMouseEvent *me)
         else
             Q_EMIT rightMouseButtonPressed(pw);
     }
-
-    update();
 }
 
 void cGLWidget::mouseReleaseEvent(QMouseEvent *me)
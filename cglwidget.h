@@ -3,18 +3,46 @@
 
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions>
+#include <QOpenGLFunctions_4_3_Core>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLBuffer>
 #include <QOpenGLFramebufferObject>
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLTexture>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
 #include <QMap>
 #include "utils.h"
+#include "glbufferpool.h"
+#include "outlinelod.h"
+#include "svg.h"
 
 struct sBufferWithColor {
     int mode;
-    QOpenGLBuffer vbo;
     QVector4D lineColor;
+    float z;
+    std::vector<GLfloat> vertices;
+};
+
+struct sVertex {
+    GLfloat x, y;
+    GLubyte color[4];
+};
+
+// placement and tint of a shared mesh, a marker or a glyph
+struct sInstance {
+    GLfloat x, y;
+    GLubyte color[4];
+};
+
+// all the geometry of one primitive mode and depth, drawn with a single call
+struct sBatch {
+    int mode;
+    float z;
+    std::vector<sVertex> vertices;
+    std::vector<GLint> firsts; // strips and loops need a range each
+    std::vector<GLsizei> counts;
+    int base = 0; // first vertex in the buffer pool
 };
 
 struct sPlane {
@@ -28,6 +56,7 @@ class cGLWidget : public QOpenGLWidget, protected QOpenGLFunctions
     Q_OBJECT
 public:
     explicit cGLWidget(QWidget *parent = nullptr);
+    ~cGLWidget();
 
     void setLightPos(const QVector3D lp);
 
@@ -49,13 +78,47 @@ public:
 
     //int mCurrFrame=0;
 
-    void addToVBO(const std::vector<GLfloat>& buffer, int mode=GL_LINES, QVector4D lineColor=QVector4D(1,1,1,1));
-    void addToVBO(const QString& name, const std::vector<GLfloat>& buffer, int mode=GL_LINES, QVector4D lineColor=QVector4D(1,1,1,1));
+    // x,y pairs, all of a batch share one z so it is not stored per vertex
+    void addToVBO(const std::vector<GLfloat>& buffer, int mode=GL_LINES, QVector4D lineColor=QVector4D(1,1,1,1), float z=0.f);
+    void addToVBO(const QString& name, const std::vector<GLfloat>& buffer, int mode=GL_LINES, QVector4D lineColor=QVector4D(1,1,1,1), float z=0.f);
+
+    // control point marker, the shared ring mesh tinted by color
+    void addMarker(QVector2D pos, QVector4D color=QVector4D(1,1,1,1));
+
+    // glyph outlines of the font, uploaded once into a static buffer
+    void setGlyphs(SVG& font);
+
+    // a line of text as glyph instances, returns its width
+    float addText(const QString& text, QVector2D pos, QVector4D color=QVector4D(1,1,1,1));
+    float addText(const QString& name, const QString& text, QVector2D pos, QVector4D color=QVector4D(1,1,1,1));
+
+    // closed outline as x,y pairs, split into chunks that are culled against
+    // the view and drawn at the coarsest level that still looks exact
+    void addOutline(const std::vector<GLfloat>& loop, QVector4D color=QVector4D(1,1,1,1), float z=0.f);
+
+    // a named outline survives clearVBOs and keeps its placement when its
+    // geometry is replaced, destroyVBO removes it
+    void addOutline(const QString& name, const std::vector<GLfloat>& loop, QVector4D color=QVector4D(1,1,1,1), float z=0.f);
+
+    // rotates a named outline by angle (radians) and then moves it by offset,
+    // nothing is rebuilt or uploaded again
+    void placeOutline(const QString& name, float angle, QVector2D offset);
+
     void clearVBOs();
 
     bool screenToWorld(QVector2D xy_ndc, int z_ndc, QVector3D &ray_world);
 
     void destroyVBO(const QString &name);
+
+    // a context of its own on an offscreen surface for a widget that is never
+    // shown, does nothing once the widget has one
+    bool initializeOffscreen();
+
+    // looks straight down at everything added so far
+    void frameScene(QSize size);
+
+    // the scene at any resolution, rendered into a framebuffer object
+    QImage renderImage(QSize size);
 protected:
     void initializeGL();
     void resizeGL(int w, int h);
@@ -67,11 +130,13 @@ protected:
     void mouseMoveEvent(QMouseEvent *me);
     void keyPressEvent(QKeyEvent *ke);
     void keyReleaseEvent(QKeyEvent *ke);
+    void focusOutEvent(QFocusEvent *fe);
 
 private:
 
-    GLuint fboHandle;
-    GLuint renderTex;
+    QOpenGLContext* mOffscreenContext = nullptr;
+    QOffscreenSurface* mOffscreenSurface = nullptr;
+    QSize mRenderSize; // set while rendering an image
 
     QMap<int, bool> mKeyDown;
 
@@ -80,7 +145,76 @@ private:
     int mAngle = 0;
 
     QMap<QString, sBufferWithColor> mNamedVBOs;
-    std::vector<sBufferWithColor> mVBOs;
+    std::vector<sBatch> mBatches;
+    std::vector<sBatch> mNamedBatches;
+
+    // the scene is append only between clears, the named buffers change on
+    // every mouse move so they live in a pool of their own
+    cGLBufferPool mScenePool;
+    cGLBufferPool mNamedPool;
+    bool mSceneDirty = false;
+    bool mNamedDirty = false;
+
+    QOpenGLFunctions_4_3_Core* mGL = nullptr;
+
+    static const GLuint cameraBinding = 0; // matches the binding of qt_camera in the shaders
+    GLuint mCameraUBO = 0;
+    int mZLocation = -1;
+    int mPlaceLocation = -1;
+
+    // one static ring mesh drawn once per marker with a single instanced call
+    QOpenGLBuffer mMarkerMesh;
+    int mMarkerMeshSize = 0;
+    std::vector<sInstance> mMarkers;
+    cGLBufferPool mMarkerPool;
+    bool mMarkersDirty = false;
+
+    // every glyph is a range of line pairs in one static buffer, text is a
+    // list of glyph instances drawn with one instanced call per glyph
+    static const int glyphs = 256;
+    QOpenGLBuffer mGlyphBuffer;
+    std::vector<sVertex> mGlyphVertices;
+    int mGlyphFirst[glyphs] = {};
+    int mGlyphCount[glyphs] = {};
+    float mGlyphAdvance[glyphs] = {};
+    bool mGlyphsDirty = false;
+
+    struct sGlyphInstance {
+        int glyph;
+        sInstance instance;
+    };
+    std::vector<sGlyphInstance> mText;
+    QMap<QString, std::vector<sGlyphInstance>> mNamedText;
+    cGLBufferPool mTextPool;
+    int mTextBase[glyphs] = {}; // first instance of every glyph in the pool
+    int mTextInstances[glyphs] = {};
+    bool mTextDirty = false;
+    std::vector<sInstance> mTextScratch;
+
+    // background grid, one static buffer with a range per level
+    static const int gridLevels = 3;
+    QOpenGLBuffer mGrid;
+    int mGridFirst[gridLevels];
+    int mGridCount[gridLevels];
+    float mGridSpacing[gridLevels];
+    std::vector<GLint> mFirsts;
+    std::vector<GLsizei> mCounts;
+
+    struct sOutline {
+        float z;
+        float co = 1.f, si = 0.f; // placement, rotation first
+        QVector2D offset;
+        std::vector<sOutlineChunk> chunks; // ranges index vertices
+        std::vector<sVertex> vertices;
+        int base = 0; // first vertex in the buffer pool
+    };
+    std::vector<sOutline> mOutlines;
+    QMap<QString, sOutline> mNamedOutlines;
+    std::vector<QVector2D> mOutlineScratch;
+    cGLBufferPool mOutlinePool;
+    cGLBufferPool mNamedOutlinePool;
+    bool mOutlinesDirty = false;
+    bool mNamedOutlinesDirty = false;
 
     QOpenGLTexture *mTexture=nullptr;
     QOpenGLTexture *mTextureHeightNormal=nullptr;
@@ -129,6 +263,21 @@ private:
     QMatrix4x4 mWorldRotate;
 
     void initShaders();
+    void drawBatches(cGLBufferPool& pool, std::vector<sBatch>& batches, bool restage);
+    void setVertexFormat();
+    void setInstanceFormat();
+    void setZ(float z);
+    void setPlacement(float co, float si, QVector2D offset);
+    void initMarkerMesh();
+    void drawMarkers();
+    void initGrid();
+    float compileText(const QString& text, QVector2D pos, QVector4D color, std::vector<sGlyphInstance>& res);
+    void drawText();
+    bool compileOutline(const std::vector<GLfloat>& loop, QVector4D color, float z, sOutline& o);
+    void drawOutline(const sOutline& o, const QMatrix4x4& viewProjection, float pixel);
+    void drawOutlines(const QMatrix4x4& viewMatrix);
+    void drawGrid();
+    float visibleExtent();
     void initTextures();
     void add(QVector<GLfloat> &b, QVector3D v, const QVector2D tc=QVector2D());
     void add2D(QVector<GLfloat> &b, const QVector2D& v);
@@ -139,6 +288,8 @@ private:
     void cylinder(const float radius, const float length, const int sections);
     bool screenToWorld(int winx, int winy, int z_ndc, QVector3D &ray_world);
     float LinearizeDepth(float depth);
+    bool movementKeyDown();
+    QSize renderSize() const;
 signals:
     void glInitialized();
     void leftMouseButtonPressed(QVector3D);
@@ -47,6 +47,8 @@
 #include <cstdlib>
 #include <ostream>
 #include <functional>
+#include <thread>
+#include <future>
 
 namespace ClipperLib {
 
@@ -93,6 +95,8 @@ struct LocalMinimum {
   cInt          Y;
   TEdge        *LeftBound;
   TEdge        *RightBound;
+  PolyType      PolyTyp;
+  IntRect       Bounds; //bounds of the path the minimum belongs to
 };
 
 struct OutPt;
@@ -884,6 +888,7 @@ ClipperBase::ClipperBase() //constructor
 {
   m_CurrentLM = m_MinimaList.begin(); //begin() == end() here
   m_UseFullRange = false;
+  m_SubjectCount = 0;
 }
 //------------------------------------------------------------------------------
 
@@ -1042,6 +1047,29 @@ TEdge* ClipperBase::ProcessBound(TEdge* E, bool NextIsForward)
 }
 //------------------------------------------------------------------------------
 
+IntRect PathBounds(const Path &pg, int highI)
+{
+  IntRect result;
+  result.left = result.right = pg[0].X;
+  result.top = result.bottom = pg[0].Y;
+  for (int i = 1; i <= highI; ++i)
+  {
+    if (pg[i].X < result.left) result.left = pg[i].X;
+    else if (pg[i].X > result.right) result.right = pg[i].X;
+    if (pg[i].Y < result.top) result.top = pg[i].Y;
+    else if (pg[i].Y > result.bottom) result.bottom = pg[i].Y;
+  }
+  return result;
+}
+//------------------------------------------------------------------------------
+
+inline bool RectsOverlap(const IntRect &r1, const IntRect &r2)
+{
+  return r1.left <= r2.right && r2.left <= r1.right &&
+    r1.top <= r2.bottom && r2.top <= r1.bottom;
+}
+//------------------------------------------------------------------------------
+
 bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
 {
 #ifdef use_lines
@@ -1139,6 +1167,7 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
   while (E != eStart);
 
   //4. Finally, add edge bounds to LocalMinima list ...
+  IntRect pathBounds = PathBounds(pg, highI);
 
   //Totally flat paths must be handled differently when adding them
   //to LocalMinima list to avoid endless loops etc ...
@@ -1156,6 +1185,8 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
     locMin.RightBound = E;
     locMin.RightBound->Side = esRight;
     locMin.RightBound->WindDelta = 0;
+    locMin.PolyTyp = PolyTyp;
+    locMin.Bounds = pathBounds;
     for (;;)
     {
       if (E->Bot.X != E->Prev->Top.X) ReverseHorizontal(*E);
@@ -1168,9 +1199,24 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
 	  return true;
   }
 
+  //the cleaned vertices of the first closed subject are kept so a difference
+  //whose clip paths all miss it can return it without sweeping
+  if (Closed && PolyTyp == ptSubject && m_SubjectCount++ == 0)
+  {
+    m_FirstSubject.clear();
+    E = eStart;
+    do
+    {
+      m_FirstSubject.push_back(E->Curr);
+      E = E->Next;
+    }
+    while (E != eStart);
+  }
+
   m_edges.push_back(edges);
   bool leftBoundIsForward;
   TEdge* EMin = 0;
+  MinimaList::size_type firstMinimum = m_MinimaList.size();
 
   //workaround to avoid an endless loop in the while loop below when
   //open paths have matching start and end points ...
@@ -1217,6 +1263,14 @@ bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
     m_MinimaList.push_back(locMin);
     if (!leftBoundIsForward) E = E2;
   }
+
+  //ProcessBound pushes minima of its own for open paths, so every minimum
+  //of this path is tagged here
+  for (MinimaList::size_type i = firstMinimum; i < m_MinimaList.size(); ++i)
+  {
+    m_MinimaList[i].PolyTyp = PolyTyp;
+    m_MinimaList[i].Bounds = pathBounds;
+  }
   return true;
 }
 //------------------------------------------------------------------------------
@@ -1241,6 +1295,8 @@ void ClipperBase::Clear()
   m_edges.clear();
   m_UseFullRange = false;
   m_HasOpenPaths = false;
+  m_FirstSubject.clear();
+  m_SubjectCount = 0;
 }
 //------------------------------------------------------------------------------
 
@@ -1332,6 +1388,24 @@ IntRect ClipperBase::GetBounds()
 }
 //------------------------------------------------------------------------------
 
+IntRect ClipperBase::GetBounds(PolyType polyTyp)
+{
+  //an empty rect (left > right) when there are no paths of this type
+  IntRect result;
+  result.left = result.top = hiRange;
+  result.right = result.bottom = -hiRange;
+  for (MinimaList::iterator lm = m_MinimaList.begin(); lm != m_MinimaList.end(); ++lm)
+  {
+    if (lm->PolyTyp != polyTyp) continue;
+    result.left = std::min(result.left, lm->Bounds.left);
+    result.top = std::min(result.top, lm->Bounds.top);
+    result.right = std::max(result.right, lm->Bounds.right);
+    result.bottom = std::max(result.bottom, lm->Bounds.bottom);
+  }
+  return result;
+}
+//------------------------------------------------------------------------------
+
 void ClipperBase::InsertScanbeam(const cInt Y)
 {
   m_Scanbeam.push(Y);
@@ -1517,8 +1591,14 @@ bool Clipper::Execute(ClipType clipType, Paths &solution,
   m_ClipFillType = clipFillType;
   m_ClipType = clipType;
   m_UsingPolyTree = false;
-  bool succeeded = ExecuteInternal();
-  if (succeeded) BuildResult(solution);
+  bool succeeded = true;
+  if (RejectDisjointPaths()) BuildResult(solution);
+  else if (!PassSubjectThrough(solution))
+  {
+    succeeded = ExecuteInternal();
+    if (succeeded) BuildResult(solution);
+  }
+  RestoreRejectedPaths();
   DisposeAllOutRecs();
   m_ExecuteLocked = false;
   return succeeded;
@@ -1534,14 +1614,76 @@ bool Clipper::Execute(ClipType clipType, PolyTree& polytree,
   m_ClipFillType = clipFillType;
   m_ClipType = clipType;
   m_UsingPolyTree = true;
-  bool succeeded = ExecuteInternal();
+  bool succeeded = RejectDisjointPaths() || ExecuteInternal();
   if (succeeded) BuildResult2(polytree);
+  RestoreRejectedPaths();
   DisposeAllOutRecs();
   m_ExecuteLocked = false;
   return succeeded;
 }
 //------------------------------------------------------------------------------
 
+bool Clipper::RejectDisjointPaths()
+{
+  //Paths whose bounds don't overlap the other polytype's bounds can't change
+  //the result of an intersection or difference, so they're set aside before
+  //the sweep. Returns true when the solution is trivially empty.
+  if (m_ClipType != ctIntersection && m_ClipType != ctDifference) return false;
+
+  IntRect subjBounds = GetBounds(ptSubject);
+  IntRect clipBounds = GetBounds(ptClip);
+  bool hasSubj = false, hasClip = false;
+
+  MinimaList::iterator kept = m_MinimaList.begin();
+  for (MinimaList::iterator lm = m_MinimaList.begin(); lm != m_MinimaList.end(); ++lm)
+  {
+    bool reject;
+    if (lm->PolyTyp == ptClip)
+      reject = !RectsOverlap(lm->Bounds, subjBounds);
+    else
+      reject = m_ClipType == ctIntersection && !RectsOverlap(lm->Bounds, clipBounds);
+
+    if (reject)
+      m_RejectedMinima.push_back(*lm);
+    else
+    {
+      if (lm->PolyTyp == ptClip) hasClip = true; else hasSubj = true;
+      *kept++ = *lm;
+    }
+  }
+  m_MinimaList.erase(kept, m_MinimaList.end());
+  m_CurrentLM = m_MinimaList.begin();
+
+  return !hasSubj || (m_ClipType == ctIntersection && !hasClip);
+}
+//------------------------------------------------------------------------------
+
+bool Clipper::PassSubjectThrough(Paths &solution)
+{
+  //A difference whose clip paths were all rejected leaves a lone simple
+  //subject as it is, so the subject is returned without sweeping. Only the
+  //cleaned vertices are known here, not whether the path crosses itself, so
+  //a self-intersecting subject comes back unsplit.
+  if (m_ClipType != ctDifference || m_RejectedMinima.empty() || m_SubjectCount != 1) return false;
+  if (m_SubjFillType != pftEvenOdd && m_SubjFillType != pftNonZero) return false;
+  for (MinimaList::iterator lm = m_MinimaList.begin(); lm != m_MinimaList.end(); ++lm)
+    if (lm->PolyTyp == ptClip) return false;
+
+  solution.push_back(m_FirstSubject);
+  if (Orientation(solution.back()) == m_ReverseOutput) ReversePath(solution.back());
+  return true;
+}
+//------------------------------------------------------------------------------
+
+void Clipper::RestoreRejectedPaths()
+{
+  if (m_RejectedMinima.empty()) return;
+  m_MinimaList.insert(m_MinimaList.end(), m_RejectedMinima.begin(), m_RejectedMinima.end());
+  m_RejectedMinima.clear();
+  m_CurrentLM = m_MinimaList.begin();
+}
+//------------------------------------------------------------------------------
+
 void Clipper::FixHoleLinkage(OutRec &outrec)
 {
   //skip OutRecs that (a) contain outermost polygons or
@@ -4520,6 +4662,67 @@ void MinkowskiSum(const Path& pattern, const Path& path, Paths& solution, bool p
 }
 //------------------------------------------------------------------------------
 
+void UnionPartialSums(Paths& sum, const Paths& other)
+{
+  Clipper c;
+  c.AddPaths(sum, ptSubject, true);
+  c.AddPaths(other, ptClip, true);
+  c.Execute(ctUnion, sum, pftNonZero, pftNonZero);
+}
+//------------------------------------------------------------------------------
+
+void WaitForTasks(std::vector<std::future<void> >& tasks)
+{
+  //get() rethrows whatever a task threw, the tasks still running are waited
+  //for by the future destructors before the partial sums go out of scope
+  for (size_t i = 0; i < tasks.size(); ++i) tasks[i].get();
+  tasks.clear();
+}
+//------------------------------------------------------------------------------
+
+void MinkowskiSumParallel(const Path& pattern, const Path& path, Paths& solution,
+  bool pathIsClosed, unsigned threads)
+{
+  if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t pathCnt = path.size();
+  size_t segCnt = pathIsClosed ? pathCnt : pathCnt - 1;
+  if (pathCnt < 2 || threads < 2 || segCnt < 2 * threads)
+  {
+    MinkowskiSum(pattern, path, solution, pathIsClosed);
+    return;
+  }
+
+  //1. each run of consecutive path segments is summed and unioned on its own
+  //thread, the runs share their end points so no quad is lost ...
+  std::vector<Paths> partial(threads);
+  std::vector<std::future<void> > tasks;
+  tasks.reserve(threads);
+  for (unsigned c = 0; c < threads; ++c)
+  {
+    size_t first = segCnt * c / threads, last = segCnt * (c + 1) / threads;
+    tasks.push_back(std::async(std::launch::async, [&, c, first, last]() {
+      Path run;
+      run.reserve(last - first + 1);
+      for (size_t i = first; i <= last; ++i) run.push_back(path[i % pathCnt]);
+      MinkowskiSum(pattern, run, partial[c], false);
+    }));
+  }
+  WaitForTasks(tasks);
+
+  //2. reduction tree, neighbouring partial sums are unioned pairwise until
+  //only one is left ...
+  for (size_t step = 1; step < partial.size(); step *= 2)
+  {
+    for (size_t i = 0; i + step < partial.size(); i += 2 * step)
+      tasks.push_back(std::async(std::launch::async, [&, i, step]() {
+        UnionPartialSums(partial[i], partial[i + step]);
+      }));
+    WaitForTasks(tasks);
+  }
+  solution.swap(partial[0]);
+}
+//------------------------------------------------------------------------------
+
 void TranslatePath(const Path& input, Path& output, const IntPoint delta)
 {
   //precondition: input != output
@@ -185,6 +185,10 @@ void CleanPolygons(Paths& polys, double distance = 1.415);
 
 void MinkowskiSum(const Path& pattern, const Path& path, Paths& solution, bool pathIsClosed);
 void MinkowskiSum(const Path& pattern, const Paths& paths, Paths& solution, bool pathIsClosed);
+//splits path into runs summed on worker threads (0 = one per core) and merges
+//the partial sums with a reduction tree, same result as MinkowskiSum
+void MinkowskiSumParallel(const Path& pattern, const Path& path, Paths& solution,
+  bool pathIsClosed, unsigned threads = 0);
 void MinkowskiDiff(const Path& poly1, const Path& poly2, Paths& solution);
 
 void PolyTreeToPaths(const PolyTree& polytree, Paths& paths);
@@ -226,6 +230,7 @@ public:
   bool AddPaths(const Paths &ppg, PolyType PolyTyp, bool Closed);
   virtual void Clear();
   IntRect GetBounds();
+  IntRect GetBounds(PolyType polyTyp);
   bool PreserveCollinear() {return m_PreserveCollinear;};
   void PreserveCollinear(bool value) {m_PreserveCollinear = value;};
 protected:
@@ -247,6 +252,9 @@ protected:
   typedef std::vector<LocalMinimum> MinimaList;
   MinimaList::iterator m_CurrentLM;
   MinimaList           m_MinimaList;
+  MinimaList           m_RejectedMinima; //set aside by Clipper::Execute
+  Path                 m_FirstSubject; //cleaned vertices of the first closed subject
+  int                  m_SubjectCount; //closed subject paths added
 
   bool              m_UseFullRange;
   EdgeList          m_edges;
@@ -305,6 +313,9 @@ private:
 #ifdef use_xyz
   ZFillCallback   m_ZFill; //custom callback 
 #endif
+  bool RejectDisjointPaths();
+  bool PassSubjectThrough(Paths &solution);
+  void RestoreRejectedPaths();
   void SetWindingCount(TEdge& edge);
   bool IsEvenOddFillType(const TEdge& edge) const;
   bool IsEvenOddAltFillType(const TEdge& edge) const;
@@ -2,8 +2,18 @@
 #include "ui_dialog.h"
 
 #include "utils.h"
+#include "polyclip.h"
+#include "offset.h"
+#include "dxfwriter.h"
+#include "dxfreader.h"
+#include "gcode.h"
+#include "extrude.h"
+#include "svgwriter.h"
+#include "project.h"
+#include "exporter.h"
 
 #include <QSound>
+#include <QSettings>
 
 using namespace ClipperLib;
 
@@ -19,6 +29,19 @@ Dialog::Dialog(QWidget *parent) : QDialog(parent), ui(new Ui::Dialog)
     ui->splitter->setStretchFactor(0, 5);
     ui->splitter->setStretchFactor(1, 1);
 
+    QSettings settings("Gearszki", "Gearszki");
+    ui->mKerf->setValue(settings.value("kerf", 0.0).toDouble());
+    ui->mBacklash->setValue(settings.value("backlash", 0.0).toDouble());
+    ui->mOutlineMode->setCurrentIndex(qBound(int(omLines), settings.value("outlineMode", omLines).toInt(), int(omSpline))); // stale settings
+    ui->mArcTolerance->setValue(settings.value("arcTolerance", 0.01).toDouble());
+    ui->mToolDiameter->setValue(settings.value("toolDiameter", 3.175).toDouble());
+    ui->mCutDepth->setValue(settings.value("cutDepth", 5.0).toDouble());
+    ui->mStepDown->setValue(settings.value("stepDown", 1.0).toDouble());
+    ui->mFeed->setValue(settings.value("feed", 1000.0).toDouble());
+    ui->mThickness->setValue(settings.value("thickness", 10.0).toDouble());
+    ui->mTwist->setValue(settings.value("twist", 0.0).toDouble());
+    ui->mChamfer->setValue(settings.value("chamfer", 0.0).toDouble());
+
     connect(ui->mGLWidget, &cGLWidget::mouseMove, this, &Dialog::onMouseMove);
 
     QStandardItemModel *model = new QStandardItemModel(this);
@@ -38,6 +61,7 @@ Dialog::Dialog(QWidget *parent) : QDialog(parent), ui(new Ui::Dialog)
     connect(ui->mGLWidget, &cGLWidget::glInitialized, this, &Dialog::onGlInitialized);
 
     mSVG.readChars();
+    ui->mGLWidget->setGlyphs(mSVG);
 
     drawScene();
 }
@@ -82,7 +106,7 @@ void Dialog::drawGuides()
         ui->mGLWidget->destroyVBO("linefToClosest");
 
     if(ui->mEditModeGroupBox->isChecked()) {
-        ui->mGLWidget->addToVBO("coords", compileText(" X:" + ftoStr(mMousePos.x()) + ", Y:" + ftoStr(mMousePos.y()), mMousePos));
+        ui->mGLWidget->addText("coords", " X:" + ftoStr(mMousePos.x()) + ", Y:" + ftoStr(mMousePos.y()), mMousePos);
         ui->mGLWidget->addToVBO("lineToCursor", lineToCursor.glFloatArray());
         ui->mGLWidget->addToVBO("lineToClosest", lineToClosest.glFloatArray(), GL_LINES, QVector4D(1,0.8f,0,1));
     } else {
@@ -102,6 +126,8 @@ void Dialog::addPoint(QVector2D p)
     QSound* s = new QSound(":/click.wav", this);
     s->play();
 
+    // editing the control points goes back to the spline
+    clearPitch();
     mPath.mPoints.push_back(calcAngleForPoint(p));
     std::sort(mPath.mPoints.begin(), mPath.mPoints.end(), [](sPoint v1, sPoint v2){
         return v1.angle < v2.angle;
@@ -129,6 +155,7 @@ void Dialog::removePoint(QVector2D p)
     if(mPath.mPoints.size()) {
         QSound* s = new QSound(":/sss.wav", this);
         s->play();
+        clearPitch();
         mPath.mPoints.erase(findMinDistPoint(p));
         rebuildModel();
     }
@@ -137,10 +164,10 @@ void Dialog::removePoint(QVector2D p)
 
 void Dialog::drawScene()
 {
+    clearMeshing();
     ui->mGLWidget->clearVBOs();
-    drawSystem();
     drawControlPoints();
-    if(mPath.mPoints.size() > 2) {
+    if(hasPitchCurve()) {
         drawSplines();
     }
 }
@@ -193,32 +220,9 @@ float Dialog::angleBetween(QVector2D v1, QVector2D v2)
     return atan2(det, dot);
 }
 
-std::vector<GLfloat> Dialog::compileText(const QString text, const QVector2D pos)
-{
-    std::vector<GLfloat> res;
-    float xOffs = 0.f;
-
-    for(int i=0; i<text.size(); i++) {
-        int chr = static_cast<int>(text[i].toLatin1());
-        std::vector<GLfloat> partialRes = mSVG.glFloatArray(chr, pos + QVector2D(xOffs, 0));
-        res.insert(res.end(), partialRes.begin(), partialRes.end());
-        xOffs += mSVG.mPoints[chr].width();
-    }
-
-    return res;
-}
-
 float Dialog::displayText(QString text, QVector2D pos)
 {
-    float xOffs = 0.f;
-
-    for(int i=0; i<text.size(); i++) {
-        int chr = static_cast<int>(text[i].toLatin1());
-        ui->mGLWidget->addToVBO(mSVG.glFloatArray(chr, pos + QVector2D(xOffs, 0)), GL_LINES);
-        xOffs += mSVG.mPoints[chr].width();
-    }
-
-    return xOffs;
+    return ui->mGLWidget->addText(text, pos);
 }
 
 void Dialog::drawSplines()
@@ -229,25 +233,39 @@ void Dialog::drawSplines()
 
     float alpha = static_cast<float>(ui->mAlpha->value());
     float tension = static_cast<float>(ui->mTension->value());
-    float totalLen = mPath.calcTotalLen(static_cast<float>(ui->mAlpha->value()), static_cast<float>(ui->mTension->value()));
+
+    // an imported pitch polygon takes the place of the spline
+    bool imported = mPitch.size() > 2;
+    size_t seg = 0;
+
+    float totalLen = imported ? mPitchLengths.back() : mPath.calcTotalLen(alpha, tension);
     float teethWidth = totalLen / ui->mTeeth->value();
     float samplingStep = teethWidth / ui->mSamples->value();
 
     mGear.clear();
     mSpline.clear();
+    mAlignment = 0.f;
 
     // the first point
-    QVector2D fp = mPath.getSplinePoint(0.f, alpha, tension);
+    QVector2D fp = imported ? mPitch.front() : mPath.getSplinePoint(0.f, alpha, tension);
     mSpline.push_back(sPoint{fp, calcAngleForPoint(fp).angle});
 
     mGear.push_back(sPoint{fp, 0.f});
 
     for(float dist=0.f; dist<=totalLen; dist+=samplingStep) {
-        float t = mPath.getT(dist, alpha, tension);
+        QVector2D p, s;
+        if(imported) {
+            p = pitchPoint(dist, seg, s);
+        } else {
+            float t = mPath.getT(dist, alpha, tension);
 
-        if(t<0.f) {
-            qd << dist << "is larger than" << totalLen;
-            continue;
+            if(t<0.f) {
+                qd << dist << "is larger than" << totalLen;
+                continue;
+            }
+
+            p = mPath.getSplinePoint(t, alpha, tension);
+            s = mPath.getSplineGradient(t, alpha, tension);
         }
 
         float normalized = dist / teethWidth;
@@ -257,9 +275,6 @@ void Dialog::drawSplines()
 
         //qd << "sampled height:" << sh;
 
-        QVector2D p = mPath.getSplinePoint(t, alpha, tension);
-        QVector2D s = mPath.getSplineGradient(t, alpha, tension);
-
         mSpline.push_back(sPoint{p, calcAngleForPoint(p).angle});
 
         float r = atan2(-s.y(), s.x());
@@ -273,40 +288,15 @@ void Dialog::drawSplines()
     }
 
     if(ui->mGearGroupBox->isChecked())
-        ui->mGLWidget->addToVBO(mGear.glFloatArray());
-
-    ui->mGLWidget->addToVBO(mSpline.glFloatArray());
-}
-
-void Dialog::drawSystem()
-{
-    PolySegs system;
-    for(int i=-2000; i<=2000; i+=100)
-    {
-        system.push_back(Seg2f(QVector2D(i,-2000), QVector2D(i, 2000)));
-        system.push_back(Seg2f(QVector2D(-2000,i), QVector2D(2000,i)));
-    }
+        ui->mGLWidget->addOutline(mGear.glFloatArray());
 
-    ui->mGLWidget->addToVBO(system.glFloatArray(-2.5f), GL_LINES, QVector4D(0.6, 0.2, 0.2, 1));
+    ui->mGLWidget->addOutline(mSpline.glFloatArray());
 }
 
 void Dialog::drawControlPoints()
 {
-    for(auto v: mPath.mPoints) {
-        sPolygon p1, p2, p3;
-        for(int i=0; i<=360; i+=10) {
-            float phi = d2r(i);
-            p1.push_back(QVector2D(sin(phi)*2, cos(phi)*2));
-            p2.push_back(QVector2D(sin(phi)*2.5f, cos(phi)*2.5f));
-            p3.push_back(QVector2D(sin(phi)*3, cos(phi)*3));
-        }
-        p1.translate(v);
-        p2.translate(v);
-        p3.translate(v);
-        ui->mGLWidget->addToVBO(p1.glFloatArray(0.5f), GL_LINES, QVector4D(0,0,0,1));
-        ui->mGLWidget->addToVBO(p2.glFloatArray(0.5f), GL_LINES, QVector4D(1.0f,0.8f,0,1));
-        ui->mGLWidget->addToVBO(p3.glFloatArray(0.5f), GL_LINES, QVector4D(0,0,0,1));
-    }
+    for(auto& v : mPath.mPoints)
+        ui->mGLWidget->addMarker(v);
 }
 
 float Dialog::sample(float t)
@@ -330,24 +320,18 @@ float Dialog::sample2(float t)
     }
 }
 
-void Dialog::rotatePath(Path& p, float angle)
-{
-    for(size_t i=0; i<p.size(); i++) {
-        float si = sin(angle);
-        float co = cos(angle);
-
-        float tx = p[i].X;
-        float ty = p[i].Y;
-
-        p[i].X = ((co * tx) - (si * ty));
-        p[i].Y = ((si * tx) + (co * ty));
-    }
-}
-
-void Dialog::translatePath(Path& p, float x)
+// rotate then translate, in double and rounded once
+void Dialog::transformPath(const Path& src, double angle, double tx, double ty, Path& dst)
 {
-    for(size_t i=0; i<p.size(); i++) {
-        p[i].X += x;
+    const double si = sin(angle);
+    const double co = cos(angle);
+
+    dst.resize(src.size());
+    for(size_t i=0; i<src.size(); i++) {
+        double x = static_cast<double>(src[i].X);
+        double y = static_cast<double>(src[i].Y);
+        dst[i].X = std::llround((co * x) - (si * y) + tx);
+        dst[i].Y = std::llround((si * x) + (co * y) + ty);
     }
 }
 
@@ -375,7 +359,6 @@ float Dialog::iterate(float ccdist)
 
 void Dialog::on_mCalculateButton_clicked()
 {
-    Clipper c;
     Paths solutions;
 
     mGear2.clear();
@@ -383,10 +366,8 @@ void Dialog::on_mCalculateButton_clicked()
     ui->mEditModeGroupBox->setChecked(false);
     ui->mGLWidget->setFocus();
 
-    float maxr = std::numeric_limits<float>::lowest();
     float rsum = 0.f;
     for(auto &p : mSpline) {
-        if(p.length() > maxr) maxr = p.length();
         rsum += p.length();
     }
 
@@ -399,63 +380,36 @@ void Dialog::on_mCalculateButton_clicked()
         ccdist -= pd(360.f, res);
     } while (fabs(360.0f - res) > 0.005f);
 
+    mCenterDistance = ccdist;
+
     // circle
     for(int i=0; i<=360; i+=10) {
-        float phi = d2r(i);
-        QVector2D v(sin(phi)*ccdist, cos(phi)*ccdist);
-        mGear2 << IntPoint(v.x()*M, v.y()*M);
+        double phi = i * M_PI / 180.0;
+        mGear2 << IntPoint(std::llround(sin(phi)*ccdist*M), std::llround(cos(phi)*ccdist*M));
     }
 
     float alignmentAngle = angleBetween(mSpline.at(0), QVector2D(1,0));
     mSpline.rotate(alignmentAngle);
     mGear.rotate(alignmentAngle);
+    mAlignment += alignmentAngle;
+    clearMeshing();
 
-    Path gear = mGear.path();
-    //writeDXF("c:/DRIVE/gear.dxf", gear);
-
-    PolySegs cross1;
-    float cs = ccdist / 10;
-    cross1.push_back(Seg2f(QVector2D(0,-cs),QVector2D(0,cs)));
-    cross1.push_back(Seg2f(QVector2D(-cs,0),QVector2D(cs,0)));
-
-    PolySegs cross2(cross1);
-
-    float textHeight = mSVG.mPoints[65].height();
-    float textHeight3 = textHeight * 3;
+    // the mating gear keeps its own frame, each step the cutter is placed into it
+    // from the canonical driver using the accumulated angles, rounded once
+    const Path driver = ui->mGearGroupBox->isChecked() ? mGear.path() : mSpline.path();
+    Path cutter;
+    double driverAngle = 0.0, matingAngle = 0.0;
 
     //qd << "spline size:" << mSpline.size();
 
     for(size_t i=0; i<mSpline.size(); ++i) {
-        size_t j = i+1; if(j==mSpline.size()) j=0;
-
-        float r1 = mSpline.at(i).length();
-        float r2 = ccdist - mSpline.at(i).length();
-
-        float aDiff = angleBetween(mSpline.at(i), mSpline.at(j));
-
-        float ratio = r1 / r2;
-
-        float oAngle = aDiff * ratio;
-
-        mSpline.rotate(-aDiff);
-        mGear.rotate(-aDiff);
+        float r1;
+        stepMeshing(i, driverAngle, matingAngle, r1);
 
-        cross1.rotate(-aDiff);
+        transformPath(driver, driverAngle - matingAngle, -ccdist*M*cos(matingAngle), ccdist*M*sin(matingAngle), cutter);
 
-        rotatePath(mGear2, oAngle);
-        cross2.rotate(oAngle);
-
-        if(ui->mGearGroupBox->isChecked())
-            gear = mGear.path();
-        else
-            gear = mSpline.path();
-
-        translatePath(gear, -ccdist*M);
-
-        c.AddPath(gear, ptClip, true);
-        c.AddPath(mGear2, ptSubject, true);
-        c.Execute(ctDifference, solutions, pftNonZero, pftNonZero);
-        c.Clear();
+        // the cutter is neither small nor convex, this always takes the Clipper path
+        polyBoolean(ctDifference, mGear2, cutter, solutions);
 
         // sort results baseed on the amount of points
         using tPair = std::pair<size_t,size_t>;
@@ -467,79 +421,129 @@ void Dialog::on_mCalculateButton_clicked()
         });
         mGear2 = solutions[idxnsizes[0].first];
 
-        ui->mGLWidget->clearVBOs();
+        drawMeshing(driver, driverAngle, matingAngle, r1);
 
-        drawSystem();
+        //drawVectors(-ccdist, 0.f);
 
-        PolySegs vLine1, vLine2, vLine3;
-        mGear.calcBounds();
-        QVector2D ep1(-ccdist, -maxr-textHeight3);
-        vLine1.push_back(Seg2f(QVector2D(-ccdist,0),ep1));
+        ui->mGLWidget->update();
+        QApplication::processEvents();
+    }
 
-        // arrow1
-        vLine1.push_back(Seg2f(ep1,ep1+QVector2D(textHeight,textHeight/3)));
-        vLine1.push_back(Seg2f(ep1,ep1+QVector2D(textHeight,-textHeight/3)));
+    //writeDXF("c:/DRIVE/gear2.dxf", path);
+}
 
-        QVector2D ep2(-ccdist + r1, -maxr-textHeight3);
-        vLine2.push_back(Seg2f(QVector2D(-ccdist+r1,0),ep2));
+// rolls both pitch curves on by the segment starting at sample i, or by the
+// fraction t of it
+void Dialog::stepMeshing(size_t i, double& driverAngle, double& matingAngle, float& r1, float t)
+{
+    size_t j = i+1; if(j==mSpline.size()) j=0;
 
-        // arrow2
-        vLine1.push_back(Seg2f(ep2,ep2+QVector2D(-textHeight,textHeight/3)));
-        vLine1.push_back(Seg2f(ep2,ep2+QVector2D(-textHeight,-textHeight/3)));
+    r1 = mSpline.at(i).length();
+    float r2 = mCenterDistance - r1;
 
-        // arrow3
-        vLine2.push_back(Seg2f(ep2,ep2+QVector2D(textHeight,textHeight/3)));
-        vLine2.push_back(Seg2f(ep2,ep2+QVector2D(textHeight,-textHeight/3)));
+    float aDiff = angleBetween(mSpline.at(i), mSpline.at(j)) * t;
 
-        QVector2D ep3(0, -maxr-textHeight3);
-        vLine3.push_back(Seg2f(QVector2D(0,0),ep3));
+    float ratio = r1 / r2;
 
-        // arrow3
-        vLine3.push_back(Seg2f(ep3,ep3+QVector2D(-textHeight,textHeight/3)));
-        vLine3.push_back(Seg2f(ep3,ep3+QVector2D(-textHeight,-textHeight/3)));
+    float oAngle = aDiff * ratio;
 
-        // connect endpoints
-        vLine1.push_back(Seg2f(ep1,ep3));
+    driverAngle -= aDiff;
+    matingAngle += oAngle;
+}
 
-        displayText(ftoStr(r1), ep1+QVector2D(0,-textHeight));
-        displayText(ftoStr(r2), ep2+QVector2D(0,-textHeight));
+// the spline and driver outlines of the meshing view are built once after
+// this, the calculation or a project changes them
+void Dialog::clearMeshing()
+{
+    ui->mGLWidget->destroyVBO("meshSpline");
+    ui->mGLWidget->destroyVBO("meshDriver");
+    ui->mGLWidget->destroyVBO("meshMating");
+    mMeshingDirty = true;
+}
 
-        ui->mGLWidget->addToVBO(vLine1.glFloatArray(), GL_LINES, QVector4D(0,1,1,1));
-        ui->mGLWidget->addToVBO(vLine2.glFloatArray(), GL_LINES, QVector4D(0,1,1,1));
-        ui->mGLWidget->addToVBO(vLine3.glFloatArray(), GL_LINES, QVector4D(0,1,1,1));
+void Dialog::drawMeshing(const Path& driver, double driverAngle, double matingAngle, float r1, bool matingChanged)
+{
+    float ccdist = mCenterDistance;
+    float r2 = ccdist - r1;
 
-        ui->mGLWidget->addToVBO(cross1.translated(QVector2D(-ccdist,0)).glFloatArray(), GL_LINES, QVector4D(0,0,1,1));
-        ui->mGLWidget->addToVBO(cross2.glFloatArray());
+    float maxr = 0.f;
+    for(auto &p : mSpline)
+        maxr = std::max(maxr, p.length());
 
-        ui->mGLWidget->addToVBO(mSpline.translated(QVector2D(-ccdist, 0)).glFloatArray(), GL_LINE_LOOP);
+    PolySegs cross;
+    float cs = ccdist / 10;
+    cross.push_back(Seg2f(QVector2D(0,-cs),QVector2D(0,cs)));
+    cross.push_back(Seg2f(QVector2D(-cs,0),QVector2D(cs,0)));
 
-        ui->mGLWidget->addToVBO(pathToGLfloatArray(gear));
-        ui->mGLWidget->addToVBO(pathToGLfloatArray(mGear2));
+    float textHeight = mSVG.mPoints[65].height();
+    float textHeight3 = textHeight * 3;
 
-        //drawVectors(-ccdist, 0.f);
+    ui->mGLWidget->clearVBOs();
 
-        //QPixmap pixmap = ui->widget->grab(QRect(0,0,ui->widget->width(), ui->widget->height()));
-        //QString fname = QString("%1").arg(i, 3, 10, QChar('0'));
-        //pixmap.save("C:/DRIVE/gear_frames/"+fname+".png");
+    PolySegs vLine1, vLine2, vLine3;
+    mGear.calcBounds();
+    QVector2D ep1(-ccdist, -maxr-textHeight3);
+    vLine1.push_back(Seg2f(QVector2D(-ccdist,0),ep1));
 
-        ui->mGLWidget->update();
-        QApplication::processEvents();
+    // arrow1
+    vLine1.push_back(Seg2f(ep1,ep1+QVector2D(textHeight,textHeight/3)));
+    vLine1.push_back(Seg2f(ep1,ep1+QVector2D(textHeight,-textHeight/3)));
+
+    QVector2D ep2(-ccdist + r1, -maxr-textHeight3);
+    vLine2.push_back(Seg2f(QVector2D(-ccdist+r1,0),ep2));
+
+    // arrow2
+    vLine1.push_back(Seg2f(ep2,ep2+QVector2D(-textHeight,textHeight/3)));
+    vLine1.push_back(Seg2f(ep2,ep2+QVector2D(-textHeight,-textHeight/3)));
+
+    // arrow3
+    vLine2.push_back(Seg2f(ep2,ep2+QVector2D(textHeight,textHeight/3)));
+    vLine2.push_back(Seg2f(ep2,ep2+QVector2D(textHeight,-textHeight/3)));
+
+    QVector2D ep3(0, -maxr-textHeight3);
+    vLine3.push_back(Seg2f(QVector2D(0,0),ep3));
+
+    // arrow3
+    vLine3.push_back(Seg2f(ep3,ep3+QVector2D(-textHeight,textHeight/3)));
+    vLine3.push_back(Seg2f(ep3,ep3+QVector2D(-textHeight,-textHeight/3)));
+
+    // connect endpoints
+    vLine1.push_back(Seg2f(ep1,ep3));
+
+    displayText(ftoStr(r1), ep1+QVector2D(0,-textHeight));
+    displayText(ftoStr(r2), ep2+QVector2D(0,-textHeight));
+
+    ui->mGLWidget->addToVBO(vLine1.glFloatArray(), GL_LINES, QVector4D(0,1,1,1));
+    ui->mGLWidget->addToVBO(vLine2.glFloatArray(), GL_LINES, QVector4D(0,1,1,1));
+    ui->mGLWidget->addToVBO(vLine3.glFloatArray(), GL_LINES, QVector4D(0,1,1,1));
+
+    ui->mGLWidget->addToVBO(cross.rotated(driverAngle).translated(QVector2D(-ccdist,0)).glFloatArray(), GL_LINES, QVector4D(0,0,1,1));
+    ui->mGLWidget->addToVBO(cross.rotated(matingAngle).glFloatArray());
+
+    // the outlines stay in their own frames, each step only moves them and
+    // the mating gear is rebuilt when the cut changed it
+    if(mMeshingDirty) {
+        ui->mGLWidget->addOutline("meshSpline", mSpline.glFloatArray());
+        ui->mGLWidget->addOutline("meshDriver", pathToGLfloatArray(driver));
+        mMeshingDirty = false;
+        matingChanged = true;
     }
+    if(matingChanged)
+        ui->mGLWidget->addOutline("meshMating", pathToGLfloatArray(mGear2));
 
-    //writeDXF("c:/DRIVE/gear2.dxf", path);
+    ui->mGLWidget->placeOutline("meshSpline", driverAngle, QVector2D(-ccdist, 0));
+    ui->mGLWidget->placeOutline("meshDriver", driverAngle, QVector2D(-ccdist, 0));
+    ui->mGLWidget->placeOutline("meshMating", matingAngle, QVector2D());
 }
 
-std::vector<GLfloat> Dialog::pathToGLfloatArray(Path& path)
+// every vertex once, the loop closes in addOutline
+std::vector<GLfloat> Dialog::pathToGLfloatArray(const Path& path)
 {
     std::vector<GLfloat> res;
-    for(size_t i=0; i<path.size(); i++) {
-        size_t j = i+1; if(j==path.size()) j=0;
-        res.push_back(path.at(i).X/M);
-        res.push_back(path.at(i).Y/M);
-        res.push_back(0.f);
-        res.push_back(path.at(j).X/M);
-        res.push_back(path.at(j).Y/M);
-        res.push_back(0.f);
+    res.reserve(path.size() * 2);
+    for(auto& p : path) {
+        res.push_back(p.X/M);
+        res.push_back(p.Y/M);
     }
     return res;
 }
@@ -552,58 +556,94 @@ void Dialog::drawVectors(float x, float y)
     }
 }
 
-void Dialog::writeDXF(QString fname, Path poly)
-{
-    int id=115;
-    writeFile(fname, readFile(":/dxf1.txt"));
-    for(size_t i=0; i<poly.size(); i++) {
-        size_t j=i+1; if(j==poly.size()) j=0;
-        QString line = DXF_Line(id++, poly[i].X/M, poly[i].Y/M, 0, poly[j].X/M, poly[j].Y/M, 0);
-        appendFile(fname, line.toUtf8());
-    }
-    appendFile(fname, readFile(":/dxf2.txt"));
-}
-
-QString Dialog::DXF_Line(int id, float x1, float y1, float z1, float x2, float y2, float z2)
-{
-    //qd << x1 << y1 << x2 << y2;
-
-    char b[4096]={0};
-    int length;
-    length = sprintf(b,
-                     "LINE\r\n"
-                     "5\r\n"
-                     "%02X\r\n"
-                     "330\r\n"
-                     "1F\r\n"
-                     "100\r\n"
-                     "AcDbEntity\r\n"
-                     "8\r\n"
-                     "0\r\n"
-                     "6\r\n"
-                     "Continuous\r\n"
-                     "62\r\n"
-                     "7\r\n"
-                     "100\r\n"
-                     "AcDbLine\r\n"
-                     "10\r\n"
-                     "%f\r\n"
-                     "20\r\n"
-                     "%f\r\n"
-                     "30\r\n"
-                     "%f\r\n"
-                     "11\r\n"
-                     "%f\r\n"
-                     "21\r\n"
-                     "%f\r\n"
-                     "31\r\n"
-                     "%f\r\n"
-                     "0\r\n",id, x1, y1, z1, x2, y2, z2);
-
-    QString res(b);
+std::vector<QVector2D> Dialog::pitchBezier()
+{
+    double alpha = ui->mAlpha->value();
+    double tension = ui->mTension->value();
+
+    float si = sin(mAlignment);
+    float co = cos(mAlignment);
+
+    auto rotated = [=](QVector2D v) {
+        return QVector2D(co * v.x() - si * v.y(), si * v.x() + co * v.y());
+    };
+
+    std::vector<QVector2D> res;
+
+    // the imported polygon, every edge as a straight cubic
+    if(mPitch.size() > 2) {
+        for(size_t i=0; i<mPitch.size(); i++) {
+            QVector2D a = mPitch[i];
+            QVector2D b = mPitch[(i+1) % mPitch.size()];
+            res.push_back(rotated(a));
+            res.push_back(rotated(a + (b - a) / 3.0f));
+            res.push_back(rotated(a + (b - a) * 2.0f / 3.0f));
+        }
+        res.push_back(rotated(mPitch.front()));
+        return res;
+    }
+
+    QVector2D ctrl[4];
+    for(size_t i=0; i<mPath.mPoints.size(); i++) {
+        mPath.bezier(i, alpha, tension, ctrl);
+        for(int k=0; k<4; k++) {
+            if(k == 3 && i+1 < mPath.mPoints.size()) break; // shared with the next segment
+            res.push_back(rotated(ctrl[k]));
+        }
+    }
     return res;
 }
 
+bool Dialog::hasPitchCurve()
+{
+    return mPath.mPoints.size() > 2 || mPitch.size() > 2;
+}
+
+void Dialog::setPitch(const std::vector<QVector2D>& outline)
+{
+    mPitch.clear();
+    for(auto& p : outline) mPitch.push_back(sPoint{p, 0.f});
+
+    // the spline runs counter clockwise, so does the pitch polygon
+    double area = 0.0;
+    for(size_t i=0; i<mPitch.size(); i++) {
+        size_t j = i+1; if(j==mPitch.size()) j=0;
+        area += static_cast<double>(mPitch[i].x()) * mPitch[j].y() - static_cast<double>(mPitch[j].x()) * mPitch[i].y();
+    }
+    if(area < 0.0) std::reverse(mPitch.begin(), mPitch.end());
+
+    // arc length at every vertex, the last entry closes the loop
+    double len = 0.0;
+    mPitchLengths.assign(1, 0.f);
+    for(size_t i=0; i<mPitch.size(); i++) {
+        size_t j = i+1; if(j==mPitch.size()) j=0;
+        len += (mPitch[j] - mPitch[i]).length();
+        mPitchLengths.push_back(static_cast<float>(len));
+    }
+}
+
+void Dialog::clearPitch()
+{
+    mPitch.clear();
+    mPitchLengths.clear();
+}
+
+// point and direction on the imported pitch polygon at arc length dist, seg
+// carries the edge over from the previous call as the distances only grow
+QVector2D Dialog::pitchPoint(float dist, size_t& seg, QVector2D& gradient)
+{
+    size_t n = mPitch.size();
+    while(seg+1 < n && mPitchLengths[seg+1] < dist) seg++;
+
+    QVector2D a = mPitch[seg];
+    QVector2D b = mPitch[(seg+1) % n];
+    float len = mPitchLengths[seg+1] - mPitchLengths[seg];
+    float t = len > 0.f ? (dist - mPitchLengths[seg]) / len : 0.f;
+
+    gradient = b - a;
+    return a + (b - a) * std::min(std::max(t, 0.f), 1.f);
+}
+
 float Dialog::pd(float sp, float mv)
 {
     float error = sp-mv;
@@ -637,6 +677,61 @@ void Dialog::on_mSamples_valueChanged(int /*arg1*/)
     drawScene();
 }
 
+void Dialog::on_mKerf_valueChanged(double arg1)
+{
+    QSettings("Gearszki", "Gearszki").setValue("kerf", arg1);
+}
+
+void Dialog::on_mBacklash_valueChanged(double arg1)
+{
+    QSettings("Gearszki", "Gearszki").setValue("backlash", arg1);
+}
+
+void Dialog::on_mOutlineMode_currentIndexChanged(int index)
+{
+    QSettings("Gearszki", "Gearszki").setValue("outlineMode", index);
+}
+
+void Dialog::on_mArcTolerance_valueChanged(double arg1)
+{
+    QSettings("Gearszki", "Gearszki").setValue("arcTolerance", arg1);
+}
+
+void Dialog::on_mToolDiameter_valueChanged(double arg1)
+{
+    QSettings("Gearszki", "Gearszki").setValue("toolDiameter", arg1);
+}
+
+void Dialog::on_mCutDepth_valueChanged(double arg1)
+{
+    QSettings("Gearszki", "Gearszki").setValue("cutDepth", arg1);
+}
+
+void Dialog::on_mStepDown_valueChanged(double arg1)
+{
+    QSettings("Gearszki", "Gearszki").setValue("stepDown", arg1);
+}
+
+void Dialog::on_mFeed_valueChanged(double arg1)
+{
+    QSettings("Gearszki", "Gearszki").setValue("feed", arg1);
+}
+
+void Dialog::on_mThickness_valueChanged(double arg1)
+{
+    QSettings("Gearszki", "Gearszki").setValue("thickness", arg1);
+}
+
+void Dialog::on_mTwist_valueChanged(double arg1)
+{
+    QSettings("Gearszki", "Gearszki").setValue("twist", arg1);
+}
+
+void Dialog::on_mChamfer_valueChanged(double arg1)
+{
+    QSettings("Gearszki", "Gearszki").setValue("chamfer", arg1);
+}
+
 void Dialog::on_mEditModeGroupBox_toggled(bool checked)
 {
     if(checked) {
@@ -685,28 +780,384 @@ void Dialog::on_mGearGroupBox_toggled(bool gear)
     drawScene();
 }
 
+QString Dialog::askExportName(int index, const QString& what, const QString& suffix, const QString& filter)
+{
+    bool gearMode = ui->mGearGroupBox->isChecked();
+    QString part = QString(index ? "secondary " : "main ") + (gearMode ? "gear" : "friction disk");
+    QString title = what.isEmpty() ? "Save " + part : "Save " + part + " " + what;
+    QString name = QString(gearMode ? "./gear%1." : "./friction_disc%1.").arg(index + 1) + suffix;
+    return QFileDialog::getSaveFileName(this, title, name, filter);
+}
+
 void Dialog::on_mSaveButton_clicked()
 {
-    if(mPath.mPoints.size() > 2) {
-        QString fname;
-        if(ui->mGearGroupBox->isChecked()) {
-            fname = QFileDialog::getSaveFileName(this, tr("Save main gear"), "./gear1.dxf", tr("DXF file (*.dxf)"));
-            writeDXF(fname, mGear.path());
-        } else {
-            fname = QFileDialog::getSaveFileName(this, tr("Save main friction disk"), "./friction_disc1.dxf", tr("DXF file (*.dxf)"));
-            writeDXF(fname, mSpline.path());
+    bool gearMode = ui->mGearGroupBox->isChecked();
+    OutlineMode mode = OutlineMode(qBound(int(omLines), ui->mOutlineMode->currentIndex(), int(omSpline)));
+    double tolerance = ui->mArcTolerance->value();
+    double arcTolerance = tolerance * M;
+
+    // kerf is compensated on every outline, backlash only thins the mating gear
+    double kerf = ui->mKerf->value() / 2 * M;
+    double backlash = gearMode ? ui->mBacklash->value() * M : 0.0;
+
+    std::vector<sExportJob> jobs;
+
+    if(hasPitchCurve()) {
+        QString fname = askExportName(0, "", "dxf", tr("DXF file (*.dxf)"));
+        if(!fname.isEmpty()) {
+            Paths driver{gearMode ? mGear.path() : mSpline.path()};
+            // without teeth or kerf the outline is the pitch curve itself
+            std::vector<QVector2D> pitch;
+            if(!gearMode && kerf == 0.0 && mode == omSpline) pitch = pitchBezier();
+            jobs.push_back(sExportJob(fname, [=]() {
+                sOffsetJob job(driver, kerf, arcTolerance);
+                offsetPaths(job);
+                return writeDXF(fname, job.result, 1.0 / M, mode, tolerance, pitch);
+            }));
         }
     }
 
     if(mGear2.size()) {
-        QString fname;
-        if(ui->mGearGroupBox->isChecked()) {
-            fname = QFileDialog::getSaveFileName(this, tr("Save secondary gear"), "./gear2.dxf", tr("DXF file (*.dxf)"));
-        } else {
-            fname = QFileDialog::getSaveFileName(this, tr("Save main friction disk"), "./friction_disc1.dxf", tr("DXF file (*.dxf)"));
+        QString fname = askExportName(1, "", "dxf", tr("DXF file (*.dxf)"));
+        if(!fname.isEmpty()) {
+            Paths mating{mGear2};
+            jobs.push_back(sExportJob(fname, [=]() {
+                sOffsetJob job(mating, kerf - backlash, arcTolerance);
+                offsetPaths(job);
+                return writeDXF(fname, job.result, 1.0 / M, mode, tolerance);
+            }));
+        }
+    }
+
+    runExports(this, tr("Saving DXF"), "Gear(s) saved successfully!", jobs);
+}
+
+void Dialog::on_mSaveGCodeButton_clicked()
+{
+    bool gearMode = ui->mGearGroupBox->isChecked();
+
+    sGCodeParams params;
+    params.toolDiameter = ui->mToolDiameter->value();
+    params.depth = ui->mCutDepth->value();
+    params.stepDown = ui->mStepDown->value();
+    params.feed = ui->mFeed->value();
+    params.plungeFeed = params.feed / 4;
+    params.leadLength = params.toolDiameter / 2;
+    params.arcTolerance = ui->mArcTolerance->value();
+    double arcTolerance = params.arcTolerance * M;
+
+    // the tool radius takes the place of the kerf, backlash still thins the mating gear
+    double radius = params.toolDiameter / 2 * M;
+    double backlash = gearMode ? ui->mBacklash->value() * M : 0.0;
+
+    std::vector<sExportJob> jobs;
+
+    if(hasPitchCurve()) {
+        QString fname = askExportName(0, "toolpath", "nc", tr("G-code file (*.nc *.ngc *.gcode)"));
+        if(!fname.isEmpty()) {
+            Paths driver{gearMode ? mGear.path() : mSpline.path()};
+            jobs.push_back(sExportJob(fname, [=]() {
+                sOffsetJob job(driver, radius, arcTolerance);
+                offsetPaths(job);
+                return writeGCode(fname, job.result, 1.0 / M, params);
+            }));
+        }
+    }
+
+    if(mGear2.size()) {
+        QString fname = askExportName(1, "toolpath", "nc", tr("G-code file (*.nc *.ngc *.gcode)"));
+        if(!fname.isEmpty()) {
+            Paths mating{mGear2};
+            jobs.push_back(sExportJob(fname, [=]() {
+                sOffsetJob job(mating, radius - backlash, arcTolerance);
+                offsetPaths(job);
+                return writeGCode(fname, job.result, 1.0 / M, params);
+            }));
+        }
+    }
+
+    runExports(this, tr("Saving toolpaths"), "Toolpath(s) saved successfully!", jobs);
+}
+
+void Dialog::on_mSaveSTLButton_clicked()
+{
+    bool gearMode = ui->mGearGroupBox->isChecked();
+
+    sExtrudeParams params;
+    params.thickness = ui->mThickness->value();
+    params.twist = ui->mTwist->value();
+    params.chamfer = ui->mChamfer->value();
+    double arcTolerance = ui->mArcTolerance->value() * M;
+
+    // printed parts need no kerf, backlash still thins the mating gear
+    double backlash = gearMode ? ui->mBacklash->value() * M : 0.0;
+
+    std::vector<sExportJob> jobs;
+
+    if(hasPitchCurve()) {
+        QString fname = askExportName(0, "mesh", "stl", tr("STL file (*.stl)"));
+        if(!fname.isEmpty()) {
+            Paths driver{gearMode ? mGear.path() : mSpline.path()};
+            jobs.push_back(sExportJob(fname, [=]() {
+                return writeSTL(fname, driver, 1.0 / M, params);
+            }));
+        }
+    }
+
+    if(mGear2.size()) {
+        QString fname = askExportName(1, "mesh", "stl", tr("STL file (*.stl)"));
+        if(!fname.isEmpty()) {
+            Paths mating{mGear2};
+            // the mating gear meshes with the driver, so its helix runs the other way
+            sExtrudeParams matingParams = params;
+            matingParams.twist = -params.twist;
+            jobs.push_back(sExportJob(fname, [=]() {
+                sOffsetJob job(mating, -backlash, arcTolerance);
+                offsetPaths(job);
+                return writeSTL(fname, job.result, 1.0 / M, matingParams);
+            }));
+        }
+    }
+
+    runExports(this, tr("Saving meshes"), "Mesh(es) saved successfully!", jobs);
+}
+
+// the drawing is built from copies, it runs on the thread pool
+static bool writeDrawing(const QString& fname, bool gearMode, const Path& driver, const Path& mating, const std::vector<QVector2D>& pitchCurve, float centerDistance)
+{
+    // the pose the rolling calculation starts from, driver on the left
+    float dx = mating.size() ? -centerDistance : 0.f;
+
+    Bounds2D bounds;
+    bounds.init();
+    for(auto& p : driver) bounds.add(QVector2D(p.X/M + dx, p.Y/M));
+    for(auto& p : mating) bounds.add(QVector2D(p.X/M, p.Y/M));
+
+    float textHeight = std::max(bounds.maxX - bounds.minX, bounds.maxY - bounds.minY) / 50;
+    float margin = textHeight * 3;
+
+    cSVGWriter svg;
+    if(!svg.open(fname, bounds.minX - margin, bounds.minY - margin, bounds.maxX + margin, bounds.maxY + margin))
+        return false;
+
+    const char* outline = "fill=\"none\" stroke=\"#000\" stroke-width=\".1\"";
+    const char* pitch = "fill=\"none\" stroke=\"#00f\" stroke-width=\".05\"";
+    const char* annotation = "fill=\"none\" stroke=\"#0aa\" stroke-width=\".05\"";
+
+    // a friction disc is its pitch curve, so that one goes out exact
+    if(gearMode) {
+        svg.path(driver, 1.0 / M, dx, 0.0, outline);
+        svg.bezier(pitchCurve, dx, 0.0, pitch);
+    } else {
+        svg.bezier(pitchCurve, dx, 0.0, outline);
+    }
+
+    if(mating.size()) {
+        svg.path(mating, 1.0 / M, 0.0, 0.0, outline);
+
+        // centre distance between the two crosses, labelled below
+        float cs = textHeight;
+        for(float x : { dx, 0.f }) {
+            svg.line(x - cs, 0, x + cs, 0, annotation);
+            svg.line(x, -cs, x, cs, annotation);
+        }
+        float y = bounds.minY - textHeight;
+        svg.line(dx, 0, dx, y, annotation);
+        svg.line(0, 0, 0, y, annotation);
+        svg.line(dx, y, 0, y, annotation);
+        svg.text(dx / 2, y - textHeight * 1.5f, textHeight, "a = " + ftoStr(centerDistance) + " mm");
+    }
+
+    return svg.close();
+}
+
+void Dialog::on_mSaveSVGButton_clicked()
+{
+    if(!hasPitchCurve()) return;
+
+    QString fname = QFileDialog::getSaveFileName(this, tr("Save drawing"), "./gears.svg", tr("SVG file (*.svg)"));
+    if(fname.isEmpty()) return;
+
+    bool gearMode = ui->mGearGroupBox->isChecked();
+    Path driver = gearMode ? mGear.path() : mSpline.path();
+    Path mating = mGear2;
+    std::vector<QVector2D> pitchCurve = pitchBezier();
+    float centerDistance = mCenterDistance;
+
+    std::vector<sExportJob> jobs;
+    jobs.push_back(sExportJob(fname, [=]() {
+        return writeDrawing(fname, gearMode, driver, mating, pitchCurve, centerDistance);
+    }));
+
+    runExports(this, tr("Saving drawing"), "Drawing saved successfully!", jobs);
+}
+
+void Dialog::on_mSaveProjectButton_clicked()
+{
+    QString fname = QFileDialog::getSaveFileName(this, tr("Save project"), "./gear.gearszki", tr("Gearszki project (*.gearszki)"));
+    if(fname.isEmpty()) return;
+
+    sProject project;
+    for(auto& p : mPath.mPoints) project.controlPoints.push_back(p);
+    for(auto& p : mPitch) project.importedPitch.push_back(p);
+    project.alpha = ui->mAlpha->value();
+    project.tension = ui->mTension->value();
+    project.teeth = ui->mTeeth->value();
+    project.samples = ui->mSamples->value();
+    project.gearMode = ui->mGearGroupBox->isChecked();
+    project.kerf = ui->mKerf->value();
+    project.backlash = ui->mBacklash->value();
+
+    if(mGear2.size()) {
+        for(auto& p : mSpline) {
+            project.pitch.push_back(p);
+            project.pitchAngles.push_back(p.angle);
         }
-        writeDXF(fname, mGear2);
+        for(auto& p : mGear) project.driver.push_back(p);
+        project.mating = mGear2;
+        project.centerDistance = mCenterDistance;
+        project.alignment = mAlignment;
+    }
+
+    if(!saveProject(fname, project))
+        QMessageBox::warning(this, "Error", "Could not write " + fname);
+}
+
+void Dialog::on_mOpenProjectButton_clicked()
+{
+    QString fname = QFileDialog::getOpenFileName(this, tr("Open project"), ".", tr("Gearszki project (*.gearszki)"));
+    if(fname.isEmpty()) return;
+
+    if(!openProject(fname))
+        QMessageBox::warning(this, "Error", "Could not read " + fname);
+}
+
+bool Dialog::openProject(const QString& fname)
+{
+    sProject project;
+    if(!loadProject(fname, project))
+        return false;
+
+    {
+        // every input would redraw the scene, that is done once at the end,
+        // kerf and backlash would overwrite the user's defaults in the settings
+        QSignalBlocker b1(ui->mAlpha), b2(ui->mTension), b3(ui->mTeeth), b4(ui->mSamples), b5(ui->mGearGroupBox);
+        QSignalBlocker b6(ui->mKerf), b7(ui->mBacklash);
+        ui->mAlpha->setValue(project.alpha);
+        ui->mTension->setValue(project.tension);
+        ui->mTeeth->setValue(project.teeth);
+        ui->mSamples->setValue(project.samples);
+        ui->mGearGroupBox->setChecked(project.gearMode);
+        ui->mGearParamsFrame->setVisible(project.gearMode);
+        ui->mFrictionDiscLabel->setVisible(!project.gearMode);
+        ui->mKerf->setValue(project.kerf);
+        ui->mBacklash->setValue(project.backlash);
     }
 
-    QMessageBox::information(this, "Success", "Gear(s) saved successfully!");
+    if(project.importedPitch.size() > 2) setPitch(project.importedPitch);
+    else clearPitch();
+    mPath.mPoints.clear();
+    for(auto& p : project.controlPoints) mPath.mPoints.push_back(calcAngleForPoint(p));
+    std::sort(mPath.mPoints.begin(), mPath.mPoints.end(), [](sPoint v1, sPoint v2){
+        return v1.angle < v2.angle;
+    });
+    rebuildModel();
+
+    mGear2 = project.mating;
+    if(mGear2.empty() || project.pitch.empty()) {
+        drawScene();
+        return true;
+    }
+
+    // the cached result, shown the way the calculation starts
+    mSpline.clear();
+    for(size_t i=0; i<project.pitch.size(); i++) mSpline.push_back(sPoint{project.pitch[i], project.pitchAngles[i]});
+    mGear.clear();
+    for(auto& p : project.driver) mGear.push_back(sPoint{p, 0.f});
+    mCenterDistance = project.centerDistance;
+    mAlignment = project.alignment;
+
+    ui->mEditModeGroupBox->setChecked(false);
+    const Path driver = project.gearMode ? mGear.path() : mSpline.path();
+    clearMeshing();
+    drawMeshing(driver, 0.0, 0.0, mSpline.at(0).length());
+    ui->mGLWidget->update();
+    return true;
+}
+
+// <base>.png shows the project as it opens, with frames the finished pair
+// also turns once, sampled evenly into <base>_0000.png and on
+bool Dialog::renderProject(const QString& fname, const QString& base, QSize size, int frames)
+{
+    cGLWidget* gl = ui->mGLWidget;
+    if(!gl->initializeOffscreen() || !openProject(fname))
+        return false;
+
+    gl->frameScene(size);
+    if(!gl->renderImage(size).save(base + ".png"))
+        return false;
+
+    if(frames <= 0 || mGear2.empty())
+        return true;
+
+    // the camera stays where the first frame put it
+    const Path driver = ui->mGearGroupBox->isChecked() ? mGear.path() : mSpline.path();
+    double driverAngle = 0.0, matingAngle = 0.0;
+    float r1 = mSpline.at(0).length();
+    size_t n = mSpline.size();
+
+    // frames fall between samples when there are more frames than samples,
+    // the rolling is linear along each segment
+    size_t i = 0;
+    for(int frame=0; frame<frames; frame++) {
+        double pos = double(frame) * n / frames;
+        for(; i+1 <= pos; i++)
+            stepMeshing(i, driverAngle, matingAngle, r1);
+
+        double d = driverAngle, m = matingAngle;
+        float r = r1;
+        stepMeshing(i, d, m, r, float(pos - i));
+        drawMeshing(driver, d, m, r, false);
+
+        QString name = QString("%1_%2.png").arg(base).arg(frame, 4, 10, QChar('0'));
+        if(!gl->renderImage(size).save(name))
+            return false;
+    }
+
+    return true;
+}
+
+void Dialog::on_mImportButton_clicked()
+{
+    QString fname = QFileDialog::getOpenFileName(this, tr("Import DXF"), ".", tr("DXF file (*.dxf)"));
+    if(fname.isEmpty()) return;
+
+    sDXFImport dxf;
+    if(!readDXF(fname, dxf)) {
+        QMessageBox::warning(this, "Error", "Could not read " + fname);
+        return;
+    }
+
+    if(dxf.outline.size() < 3 && dxf.points.size() < 3) {
+        QMessageBox::warning(this, "Error", "No pitch curve or control points in " + fname);
+        return;
+    }
+
+    mGear2.clear();
+    mPath.mPoints.clear();
+    clearPitch();
+
+    if(dxf.outline.size() > 2) {
+        // a drawn or measured outline is the pitch curve itself
+        setPitch(dxf.outline);
+    } else {
+        // loose points become the control points of the spline
+        for(auto& p : dxf.points) mPath.mPoints.push_back(calcAngleForPoint(p));
+        std::sort(mPath.mPoints.begin(), mPath.mPoints.end(), [](sPoint v1, sPoint v2){
+            return v1.angle < v2.angle;
+        });
+    }
+
+    rebuildModel();
+    drawScene();
 }
@@ -40,16 +40,16 @@ struct PolySegs : public std::vector<Seg2f>
         }
     }
 
-    std::vector<GLfloat> glFloatArray(float z = 0.0f)
+    // x,y pairs for GL_LINES
+    std::vector<GLfloat> glFloatArray()
     {
         std::vector<GLfloat> res;
+        res.reserve(size() * 4);
         for(size_t i=0; i<size(); i++) {
             res.push_back(at(i).p0.x());
             res.push_back(at(i).p0.y());
-            res.push_back(z);
             res.push_back(at(i).p1.x());
             res.push_back(at(i).p1.y());
-            res.push_back(z);
         }
         return res;
     }
@@ -105,18 +105,15 @@ struct sPolygon : public std::vector<sPoint>
         }
     }
 
-    std::vector<GLfloat> glFloatArray(float z=0.0f)
+    // every vertex once, the loop closes in addOutline
+    std::vector<GLfloat> glFloatArray()
     {
         std::vector<GLfloat> res;
+        res.reserve(size() * 2);
         for(size_t i=0; i<size(); i++)
         {
-            size_t j=i+1; if(j==size()) j=0;
             res.push_back(at(i).x());
             res.push_back(at(i).y());
-            res.push_back(z);
-            res.push_back(at(j).x());
-            res.push_back(at(j).y());
-            res.push_back(z);
         }
         return res;
     }
@@ -125,7 +122,7 @@ struct sPolygon : public std::vector<sPoint>
     {
         Path res;
         for(auto& v : *this) {
-            res << IntPoint(v.x()*M, v.y()*M);
+            res << IntPoint(std::llround(static_cast<double>(v.x())*M), std::llround(static_cast<double>(v.y())*M));
         }
         return res;
     }
@@ -201,31 +198,46 @@ struct sSpline
         return total;
     }
 
-    QVector2D doTheMath(float t, double alpha, double tension, bool gradient)
+    // end points and end tangents of the segment starting at control point p1i
+    void segment(int p1i, double alpha, double tension, QVector2D& p1, QVector2D& p2, QVector2D& m1, QVector2D& m2)
     {
-        int p0i, p1i, p2i, p3i;
+        int p0i, p2i, p3i;
 
-        p1i = (int)t;
         p2i = (p1i + 1) % mPoints.size();
         p3i = (p2i + 1) % mPoints.size();
         p0i = p1i >= 1 ? p1i - 1 : mPoints.size() - 1;
 
         QVector2D p0 = mPoints[p0i];
-        QVector2D p1 = mPoints[p1i];
-        QVector2D p2 = mPoints[p2i];
+        p1 = mPoints[p1i];
+        p2 = mPoints[p2i];
         QVector2D p3 = mPoints[p3i];
 
-        t = t - (int)t;
-
         float t0 = 0.f;
         float t1 = t0 + qPow(distance(p0, p1), alpha);
         float t2 = t1 + qPow(distance(p1, p2), alpha);
         float t3 = t2 + qPow(distance(p2, p3), alpha);
 
-        QVector2D m1 = (1.0f - tension) * (t2 - t1) *
+        m1 = (1.0f - tension) * (t2 - t1) *
             ((p1 - p0) / (t1 - t0) - (p2 - p0) / (t2 - t0) + (p2 - p1) / (t2 - t1));
-        QVector2D m2 = (1.0f - tension) * (t2 - t1) *
+        m2 = (1.0f - tension) * (t2 - t1) *
             ((p2 - p1) / (t2 - t1) - (p3 - p1) / (t3 - t1) + (p3 - p2) / (t3 - t2));
+    }
+
+    // the same segment as an exact cubic bezier
+    void bezier(int p1i, double alpha, double tension, QVector2D ctrl[4])
+    {
+        QVector2D m1, m2;
+        segment(p1i, alpha, tension, ctrl[0], ctrl[3], m1, m2);
+        ctrl[1] = ctrl[0] + m1 / 3.0f;
+        ctrl[2] = ctrl[3] - m2 / 3.0f;
+    }
+
+    QVector2D doTheMath(float t, double alpha, double tension, bool gradient)
+    {
+        QVector2D p1, p2, m1, m2;
+        segment((int)t, alpha, tension, p1, p2, m1, m2);
+
+        t = t - (int)t;
 
         QVector2D a = 2.0f * (p1 - p2) + m1 + m2;
         QVector2D b = -3.0f * (p1 - p2) - m1 - m1 - m2;
@@ -267,7 +279,11 @@ public:
     ~Dialog();
 
     float displayText(QString text, QVector2D pos);
-    std::vector<GLfloat> compileText(const QString text, const QVector2D pos);
+
+    bool openProject(const QString& fname);
+
+    // PNG files of a project without showing the window, see main
+    bool renderProject(const QString& fname, const QString& base, QSize size, int frames);
 protected:
     bool eventFilter(QObject *o, QEvent *e);
 
@@ -280,6 +296,17 @@ private slots:
 
     void on_mTeeth_valueChanged(int arg1);
     void on_mSamples_valueChanged(int arg1);
+    void on_mKerf_valueChanged(double arg1);
+    void on_mBacklash_valueChanged(double arg1);
+    void on_mOutlineMode_currentIndexChanged(int index);
+    void on_mArcTolerance_valueChanged(double arg1);
+    void on_mToolDiameter_valueChanged(double arg1);
+    void on_mCutDepth_valueChanged(double arg1);
+    void on_mStepDown_valueChanged(double arg1);
+    void on_mFeed_valueChanged(double arg1);
+    void on_mThickness_valueChanged(double arg1);
+    void on_mTwist_valueChanged(double arg1);
+    void on_mChamfer_valueChanged(double arg1);
 
     // from gl widget
     void onGlInitialized();
@@ -299,15 +326,27 @@ private slots:
 
     void on_mCalculateButton_clicked();
     void on_mSaveButton_clicked();
+    void on_mSaveGCodeButton_clicked();
+    void on_mSaveSTLButton_clicked();
+    void on_mSaveSVGButton_clicked();
+    void on_mSaveProjectButton_clicked();
+    void on_mOpenProjectButton_clicked();
+    void on_mImportButton_clicked();
 
 private:
     Ui::Dialog *ui;
     sSpline mPath;
 
+    sPolygon mPitch; // imported pitch polygon, replaces the spline when set
+    std::vector<float> mPitchLengths;
+
     sPolygon mSpline;
     sPolygon mGear;
+    float mAlignment = 0.f; // rotation applied to mSpline and mGear by the calculation
+    float mCenterDistance = 0.f;
 
     Path mGear2;
+    bool mMeshingDirty = true; // the meshing view's spline and driver outlines need building
 
     float mP = 0.1f;
     float mD = 0.02f;
@@ -317,11 +356,19 @@ private:
 
     SVG mSVG;
 
-    void rotatePath(std::vector<IntPoint> &p, float angle);
-    void translatePath(std::vector<IntPoint> &p, float x);
+    void transformPath(const Path& src, double angle, double tx, double ty, Path& dst);
+
+    void stepMeshing(size_t i, double& driverAngle, double& matingAngle, float& r1, float t = 1.f);
+    void clearMeshing();
+    void drawMeshing(const Path& driver, double driverAngle, double matingAngle, float r1, bool matingChanged = true);
+
+    QString askExportName(int index, const QString& what, const QString& suffix, const QString& filter);
+    std::vector<QVector2D> pitchBezier();
 
-    QString DXF_Line(int id, float x1, float y1, float z1, float x2, float y2, float z2);
-    void writeDXF(QString fname, Path poly);
+    bool hasPitchCurve();
+    void setPitch(const std::vector<QVector2D>& outline);
+    void clearPitch();
+    QVector2D pitchPoint(float dist, size_t& seg, QVector2D& gradient);
 
     void drawSplines();
     sPoint calcAngleForPoint(QVector2D);
@@ -337,8 +384,7 @@ private:
     void drawVectors(float x, float y);
     float iterate(float diameter);
     float pd(float sp, float mv);
-    std::vector<GLfloat> pathToGLfloatArray(Path &path);
-    void drawSystem();
+    std::vector<GLfloat> pathToGLfloatArray(const Path &path);
     void rebuildModel();
     void drawControlPoints();
     std::vector<sPoint>::iterator findMinDistPoint(QVector2D p);
@@ -0,0 +1,579 @@
+#include "dxfreader.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+namespace {
+
+// exact powers of ten, bigger exponents go through pow
+const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                              1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// locale independent, the application locale may use a decimal comma
+double toDouble(const char* p, const char* end)
+{
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    unsigned long long mantissa = 0;
+    int digits = 0, exponent = 0;
+    for(; p < end && isDigit(*p); p++) {
+        if(digits < 18) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if(mantissa) digits++;
+        } else {
+            exponent++;
+        }
+    }
+    if(p < end && *p == '.') {
+        for(p++; p < end && isDigit(*p); p++) {
+            if(digits < 18) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if(mantissa) digits++;
+                exponent--;
+            }
+        }
+    }
+    if(p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negativeExp = false;
+        if(p < end && (*p == '-' || *p == '+')) negativeExp = *p++ == '-';
+        int e = 0;
+        for(; p < end && isDigit(*p); p++)
+            if(e < 1000) e = e * 10 + (*p - '0');
+        exponent += negativeExp ? -e : e;
+    }
+
+    double v = static_cast<double>(mantissa);
+    if(mantissa) {
+        int a = std::abs(exponent);
+        double scale = a <= 22 ? powersOf10[a] : std::pow(10.0, a);
+        v = exponent < 0 ? v / scale : v * scale;
+    }
+    return negative ? -v : v;
+}
+
+// a group code and its value, the value points into the mapped file
+struct sGroup
+{
+    int code;
+    const char* value;
+    const char* end;
+
+    bool is(const char* s) const
+    {
+        size_t n = strlen(s);
+        return size_t(end - value) == n && !memcmp(value, s, n);
+    }
+
+    double number() const { return toDouble(value, end); }
+    int integer() const { return static_cast<int>(toDouble(value, end)); }
+};
+
+class cTokenizer
+{
+public:
+    cTokenizer(const char* data, size_t size) : mPos(data), mEnd(data + size) {}
+
+    bool next(sGroup& g);
+    bool failed() const { return mFailed; }
+
+private:
+    bool line(const char*& begin, const char*& end);
+
+    const char* mPos;
+    const char* mEnd;
+    bool mFailed = false;
+};
+
+// one line with the surrounding blanks and the CR of CRLF files trimmed
+bool cTokenizer::line(const char*& begin, const char*& end)
+{
+    if(mPos >= mEnd) return false;
+
+    const char* nl = static_cast<const char*>(memchr(mPos, '\n', size_t(mEnd - mPos)));
+    begin = mPos;
+    end = nl ? nl : mEnd;
+    mPos = nl ? nl + 1 : mEnd;
+
+    while(begin < end && (*begin == ' ' || *begin == '\t')) begin++;
+    while(end > begin && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) end--;
+    return true;
+}
+
+bool cTokenizer::next(sGroup& g)
+{
+    const char* begin;
+    const char* end;
+    if(!line(begin, end)) return false;
+
+    bool negative = begin < end && *begin == '-';
+    if(negative) begin++;
+    if(begin == end) {
+        mFailed = true;
+        return false;
+    }
+    int code = 0;
+    for(; begin < end; begin++) {
+        if(!isDigit(*begin)) {
+            mFailed = true;
+            return false;
+        }
+        code = code * 10 + (*begin - '0');
+    }
+    g.code = negative ? -code : code;
+
+    if(!line(g.value, g.end)) {
+        mFailed = true;
+        return false;
+    }
+    return true;
+}
+
+enum EntityType { etNone, etLine, etLwPolyline, etPolyline, etVertex, etSpline, etPoint };
+
+typedef std::vector<QVector2D> Piece;
+
+uint64_t pointKey(const QVector2D& p)
+{
+    float xy[2] = { p.x() == 0.f ? 0.f : p.x(), p.y() == 0.f ? 0.f : p.y() }; // -0 is 0
+    uint64_t key;
+    memcpy(&key, xy, sizeof(key));
+    return key;
+}
+
+// appends the piece to the chain, reversed if its end is the one touching
+void appendPiece(Piece& chain, const Piece& piece, bool reversed)
+{
+    size_t skip = chain.size() && chain.back() == (reversed ? piece.back() : piece.front()) ? 1 : 0;
+    if(reversed) chain.insert(chain.end(), piece.rbegin() + skip, piece.rend());
+    else chain.insert(chain.end(), piece.begin() + skip, piece.end());
+}
+
+// the free end points of the pieces bucketed in a uniform grid, so the
+// nearest one is found by searching rings of cells around the query
+class cEndGrid
+{
+public:
+    cEndGrid(const std::vector<Piece>& pieces, const std::vector<char>& used);
+
+    void remove(size_t piece);
+    size_t nearest(const QVector2D& p) const;
+
+private:
+    const QVector2D& end(size_t e) const { return e & 1 ? mPieces[e/2].back() : mPieces[e/2].front(); }
+    size_t cell(const QVector2D& p) const;
+
+    const std::vector<Piece>& mPieces;
+    std::vector<std::vector<size_t>> mCells;
+    float mMinX = 0, mMinY = 0, mCell = 1;
+    int mCols = 1, mRows = 1;
+};
+
+cEndGrid::cEndGrid(const std::vector<Piece>& pieces, const std::vector<char>& used) : mPieces(pieces)
+{
+    float maxX = pieces[0].front().x(), maxY = pieces[0].front().y();
+    mMinX = maxX;
+    mMinY = maxY;
+    size_t count = 0;
+    for(size_t e=0; e<2*pieces.size(); e++) {
+        if(used[e/2]) continue;
+        const QVector2D& p = end(e);
+        mMinX = std::min(mMinX, p.x()); maxX = std::max(maxX, p.x());
+        mMinY = std::min(mMinY, p.y()); maxY = std::max(maxY, p.y());
+        count++;
+    }
+
+    float w = maxX - mMinX, h = maxY - mMinY;
+    mCell = std::max(std::sqrt(w * h / float(std::max<size_t>(count, 1))), std::max(w, h) / 1024.f);
+    if(!(mCell > 0)) mCell = 1;
+    mCols = int(w / mCell) + 1;
+    mRows = int(h / mCell) + 1;
+    mCells.assign(size_t(mCols) * mRows, std::vector<size_t>());
+
+    for(size_t e=0; e<2*pieces.size(); e++)
+        if(!used[e/2]) mCells[cell(end(e))].push_back(e);
+}
+
+size_t cEndGrid::cell(const QVector2D& p) const
+{
+    // clamped as floats, a point far off the grid would overflow an int
+    int cx = int(std::min(std::max((p.x() - mMinX) / mCell, 0.f), float(mCols - 1)));
+    int cy = int(std::min(std::max((p.y() - mMinY) / mCell, 0.f), float(mRows - 1)));
+    return size_t(cy) * mCols + cx;
+}
+
+void cEndGrid::remove(size_t piece)
+{
+    for(size_t e=2*piece; e<2*piece+2; e++) {
+        std::vector<size_t>& c = mCells[cell(end(e))];
+        auto it = std::find(c.begin(), c.end(), e);
+        if(it == c.end()) continue;
+        *it = c.back();
+        c.pop_back();
+    }
+}
+
+// the end id (2*piece, or 2*piece+1 for the back) closest to p. Every end in
+// a ring of cells further out is at least ring-1 cells away, so the search
+// stops once the best distance is below that
+size_t cEndGrid::nearest(const QVector2D& p) const
+{
+    size_t home = cell(p);
+    int hx = int(home % mCols), hy = int(home / mCols);
+    size_t best = 0;
+    float bestDist = -1;
+    for(int r=0; r<=std::max(mCols, mRows); r++) {
+        if(bestDist >= 0 && bestDist <= (r - 1) * mCell * (r - 1) * mCell) break;
+        for(int cy=hy-r; cy<=hy+r; cy++) {
+            if(cy < 0 || cy >= mRows) continue;
+            bool edge = cy == hy-r || cy == hy+r;
+            for(int cx=hx-r; cx<=hx+r; cx += edge ? 1 : 2*r) {
+                if(cx >= 0 && cx < mCols) {
+                    for(size_t e : mCells[size_t(cy) * mCols + cx]) {
+                        float d = (end(e) - p).lengthSquared();
+                        if(bestDist < 0 || d < bestDist) {
+                            bestDist = d;
+                            best = e;
+                        }
+                    }
+                }
+                if(r == 0) break;
+            }
+        }
+    }
+    return best;
+}
+
+// joins the entities end to end whatever their order and direction in the
+// file. Shared end points are found through a hash, only a gap in the
+// outline falls back to the nearest free end point, looked up in a grid
+void chainPieces(std::vector<Piece>& pieces, Piece& outline)
+{
+    pieces.erase(std::remove_if(pieces.begin(), pieces.end(), [](const Piece& p) { return p.empty(); }), pieces.end());
+    if(pieces.empty()) return;
+
+    // every piece twice, 2*i for its start and 2*i+1 for its end
+    std::unordered_multimap<uint64_t, size_t> ends;
+    for(size_t i=0; i<pieces.size(); i++) {
+        ends.insert(std::make_pair(pointKey(pieces[i].front()), 2 * i));
+        ends.insert(std::make_pair(pointKey(pieces[i].back()), 2 * i + 1));
+    }
+    std::vector<char> used(pieces.size(), 0);
+    size_t left = pieces.size() - 1;
+    std::unique_ptr<cEndGrid> grid; // built at the first gap
+
+    auto extend = [&]() {
+        auto range = ends.equal_range(pointKey(outline.back()));
+        for(auto it = range.first; it != range.second; ++it) {
+            size_t i = it->second / 2;
+            if(used[i]) continue;
+            used[i] = 1;
+            left--;
+            if(grid) grid->remove(i);
+            appendPiece(outline, pieces[i], it->second & 1);
+            return true;
+        }
+        return false;
+    };
+
+    outline = pieces[0];
+    used[0] = 1;
+
+    // both directions from the first piece, then across the gaps
+    while(left && extend()) {}
+    std::reverse(outline.begin(), outline.end());
+    while(left && extend()) {}
+
+    while(left) {
+        if(!grid) grid.reset(new cEndGrid(pieces, used));
+        size_t best = grid->nearest(outline.back());
+        used[best/2] = 1;
+        left--;
+        grid->remove(best/2);
+        appendPiece(outline, pieces[best/2], best & 1);
+        while(left && extend()) {}
+    }
+}
+
+// collects one entity at a time from the group stream, the scratch vectors
+// keep their capacity between entities
+class cEntityReader
+{
+public:
+    cEntityReader(sDXFImport& result) : mResult(result) {}
+
+    void group(const sGroup& g);
+    void finish();
+
+private:
+    void startEntity(const sGroup& g);
+    void finishEntity();
+    void append(double x, double y);
+    void startPiece(bool closed = false);
+    void closePiece();
+    void sampleSpline();
+    void deBoor(size_t span, double u);
+
+    sDXFImport& mResult;
+    std::vector<Piece> mPieces; // the curve of every entity
+    bool mClosed = false; // the last piece returns to its first vertex
+
+    bool mSectionName = false;
+    bool mEntities = false;
+    EntityType mType = etNone;
+
+    double mX = 0, mY = 0, mX2 = 0, mY2 = 0;
+    int mFlags = 0;
+    int mDegree = 0;
+    std::vector<double> mVertices; // x,y pairs of a LWPOLYLINE
+    std::vector<double> mKnots, mWeights;
+    std::vector<double> mControl, mFit;
+    std::vector<double> mScratch;
+};
+
+void cEntityReader::group(const sGroup& g)
+{
+    if(g.code == 0) {
+        finishEntity();
+        if(g.is("SECTION")) mSectionName = true;
+        else if(g.is("ENDSEC")) mEntities = false;
+        else if(mEntities) startEntity(g);
+        return;
+    }
+
+    if(mSectionName) {
+        if(g.code == 2) {
+            mEntities = g.is("ENTITIES");
+            mSectionName = false;
+        }
+        return;
+    }
+
+    if(mType == etNone) return;
+
+    switch(g.code) {
+    case 10:
+        mX = g.number();
+        break;
+    case 20:
+        mY = g.number();
+        if(mType == etLwPolyline) {
+            mVertices.push_back(mX);
+            mVertices.push_back(mY);
+        } else if(mType == etSpline) {
+            mControl.push_back(mX);
+            mControl.push_back(mY);
+        }
+        break;
+    case 11:
+        mX2 = g.number();
+        break;
+    case 21:
+        mY2 = g.number();
+        if(mType == etSpline) {
+            mFit.push_back(mX2);
+            mFit.push_back(mY2);
+        }
+        break;
+    case 40:
+        if(mType == etSpline) mKnots.push_back(g.number());
+        break;
+    case 41:
+        if(mType == etSpline) mWeights.push_back(g.number());
+        break;
+    case 70:
+        mFlags = g.integer();
+        break;
+    case 71:
+        mDegree = g.integer();
+        break;
+    }
+}
+
+void cEntityReader::startEntity(const sGroup& g)
+{
+    if(g.is("LINE")) mType = etLine;
+    else if(g.is("LWPOLYLINE")) mType = etLwPolyline;
+    else if(g.is("POLYLINE")) mType = etPolyline;
+    else if(g.is("VERTEX")) mType = etVertex; // the vertices of an old style POLYLINE
+    else if(g.is("SPLINE")) mType = etSpline;
+    else if(g.is("POINT")) mType = etPoint;
+    else mType = etNone;
+
+    mX = mY = mX2 = mY2 = 0;
+    mFlags = 0;
+    mDegree = 0;
+    mVertices.clear();
+    mKnots.clear();
+    mWeights.clear();
+    mControl.clear();
+    mFit.clear();
+}
+
+void cEntityReader::finishEntity()
+{
+    switch(mType) {
+    case etNone:
+        break;
+    case etLine:
+        startPiece();
+        append(mX, mY);
+        append(mX2, mY2);
+        break;
+    case etLwPolyline:
+        // bulges are not followed, the vertices are joined by straight lines
+        startPiece(mFlags & 1);
+        for(size_t i=0; i+1<mVertices.size(); i+=2)
+            append(mVertices[i], mVertices[i+1]);
+        break;
+    case etPolyline:
+        startPiece(mFlags & 1); // the VERTEX entities follow
+        break;
+    case etVertex:
+        // spline frame and mesh vertices are not part of the curve
+        if(mPieces.empty()) startPiece();
+        if(!(mFlags & (16 | 64 | 128))) append(mX, mY);
+        break;
+    case etSpline:
+        startPiece();
+        sampleSpline();
+        break;
+    case etPoint:
+        mResult.points.push_back(QVector2D(static_cast<float>(mX), static_cast<float>(mY)));
+        break;
+    }
+    mType = etNone;
+}
+
+void cEntityReader::finish()
+{
+    finishEntity();
+    closePiece();
+    chainPieces(mPieces, mResult.outline);
+}
+
+void cEntityReader::startPiece(bool closed)
+{
+    closePiece();
+    mPieces.push_back(Piece());
+    mClosed = closed;
+}
+
+void cEntityReader::closePiece()
+{
+    if(mClosed && mPieces.back().size() > 1 && mPieces.back().front() != mPieces.back().back())
+        mPieces.back().push_back(mPieces.back().front());
+    mClosed = false;
+}
+
+void cEntityReader::append(double x, double y)
+{
+    QVector2D p(static_cast<float>(x), static_cast<float>(y));
+    Piece& piece = mPieces.back();
+    if(piece.empty() || piece.back() != p)
+        piece.push_back(p);
+}
+
+// the control points blended for parameter u in the given knot span, in
+// homogeneous coordinates so rational splines come out right as well
+void cEntityReader::deBoor(size_t span, double u)
+{
+    size_t p = size_t(mDegree);
+    bool rational = mWeights.size() * 2 == mControl.size();
+
+    mScratch.resize((p + 1) * 3);
+    double* d = mScratch.data();
+    for(size_t j=0; j<=p; j++) {
+        size_t i = span - p + j;
+        double w = rational ? mWeights[i] : 1.0;
+        d[j*3] = mControl[i*2] * w;
+        d[j*3+1] = mControl[i*2+1] * w;
+        d[j*3+2] = w;
+    }
+
+    for(size_t r=1; r<=p; r++) {
+        for(size_t j=p; j>=r; j--) {
+            size_t i = span - p + j;
+            double den = mKnots[i + p + 1 - r] - mKnots[i];
+            double a = den > 0 ? (u - mKnots[i]) / den : 0.0;
+            for(int k=0; k<3; k++)
+                d[j*3+k] = (1 - a) * d[(j-1)*3+k] + a * d[j*3+k];
+        }
+    }
+
+    double w = d[p*3+2];
+    if(w != 0) append(d[p*3] / w, d[p*3+1] / w);
+}
+
+void cEntityReader::sampleSpline()
+{
+    size_t n = mControl.size() / 2;
+    size_t p = size_t(std::max(mDegree, 0));
+
+    if(!p || n <= p || mKnots.size() != n + p + 1) {
+        // no usable knot vector, the fit points lie on the curve
+        const std::vector<double>& pts = mFit.size() ? mFit : mControl;
+        for(size_t i=0; i+1<pts.size(); i+=2)
+            append(pts[i], pts[i+1]);
+        return;
+    }
+
+    // dense measured splines need one sample per span, sparse drawn ones more
+    size_t spans = n - p;
+    int perSpan = int(std::max<size_t>(1, std::min<size_t>(16, 4096 / spans)));
+
+    deBoor(p, mKnots[p]);
+    for(size_t k=p; k<n; k++) {
+        double u0 = mKnots[k], u1 = mKnots[k+1];
+        if(u1 <= u0) continue;
+        for(int s=1; s<=perSpan; s++)
+            deBoor(k, u0 + (u1 - u0) * s / perSpan);
+    }
+}
+
+}
+
+bool readDXF(const QString& fname, sDXFImport& result)
+{
+    result.outline.clear();
+    result.points.clear();
+
+    QFile f(fname);
+    if(!f.open(QFile::ReadOnly)) return false;
+
+    qint64 size = f.size();
+    const char* data = size ? reinterpret_cast<const char*>(f.map(0, size)) : nullptr;
+    if(!data) return false;
+
+    // only the ascii flavour is read
+    static const char binary[] = "AutoCAD Binary DXF";
+    if(size >= qint64(sizeof(binary) - 1) && !memcmp(data, binary, sizeof(binary) - 1))
+        return false;
+
+    cTokenizer tokenizer(data, size_t(size));
+    cEntityReader reader(result);
+    sGroup g;
+    while(tokenizer.next(g))
+        reader.group(g);
+    reader.finish();
+
+    if(tokenizer.failed()) return false;
+
+    // a closed outline repeats its first vertex
+    if(result.outline.size() > 1 && result.outline.front() == result.outline.back())
+        result.outline.pop_back();
+
+    return result.outline.size() || result.points.size();
+}
@@ -0,0 +1,23 @@
+#ifndef DXFREADER_H
+#define DXFREADER_H
+
+#include <QString>
+#include <QVector2D>
+
+#include <vector>
+
+// geometry found in the ENTITIES section of an ascii DXF file. LINE,
+// LWPOLYLINE, POLYLINE and SPLINE entities are chained end to end into one
+// outline, in whatever order and direction they were drawn. POINT entities
+// are kept apart
+struct sDXFImport
+{
+    std::vector<QVector2D> outline;
+    std::vector<QVector2D> points;
+};
+
+// the file is memory mapped and tokenized in place, nothing is allocated per
+// group code, so measured profiles with 100k vertices load quickly
+bool readDXF(const QString& fname, sDXFImport& result);
+
+#endif // DXFREADER_H
@@ -0,0 +1,204 @@
+#include "dxfwriter.h"
+#include "utils.h"
+
+#include <QtMath>
+
+bool cDXFWriter::open(const QString& fname)
+{
+    mId = 115;
+    if(!mOut.open(fname)) return false;
+    mOut.write(readFile(":/dxf1.txt"));
+    return true;
+}
+
+bool cDXFWriter::close()
+{
+    mOut.write(readFile(":/dxf2.txt"));
+    return mOut.close();
+}
+
+void cDXFWriter::handle()
+{
+    mOut.write("5\r\n");
+    mOut.writeHex(mId++, 2);
+    mOut.write("\r\n"
+               "330\r\n"
+               "1F\r\n");
+}
+
+void cDXFWriter::entity(const char* name, const char* subclass)
+{
+    mOut.write(name);
+    mOut.write("\r\n");
+    handle();
+    mOut.write("100\r\n"
+               "AcDbEntity\r\n"
+               "8\r\n"
+               "0\r\n"
+               "6\r\n"
+               "Continuous\r\n"
+               "62\r\n"
+               "7\r\n"
+               "100\r\n");
+    mOut.write(subclass);
+    mOut.write("\r\n");
+}
+
+void cDXFWriter::line(double x1, double y1, double z1, double x2, double y2, double z2)
+{
+    entity("LINE", "AcDbLine");
+    mOut.write("10\r\n");
+    mOut.writeFixed(x1);
+    mOut.write("\r\n20\r\n");
+    mOut.writeFixed(y1);
+    mOut.write("\r\n30\r\n");
+    mOut.writeFixed(z1);
+    mOut.write("\r\n11\r\n");
+    mOut.writeFixed(x2);
+    mOut.write("\r\n21\r\n");
+    mOut.writeFixed(y2);
+    mOut.write("\r\n31\r\n");
+    mOut.writeFixed(z2);
+    mOut.write("\r\n0\r\n");
+}
+
+void cDXFWriter::polygon(const Path& poly, double scale)
+{
+    for(size_t i=0; i<poly.size(); i++) {
+        size_t j=i+1; if(j==poly.size()) j=0;
+        line(poly[i].X * scale, poly[i].Y * scale, 0, poly[j].X * scale, poly[j].Y * scale, 0);
+    }
+}
+
+void cDXFWriter::polyline(const Path& poly, double scale)
+{
+    if(poly.empty()) return;
+
+    entity("LWPOLYLINE", "AcDbPolyline");
+    mOut.write("90\r\n");
+    mOut.writeInt(poly.size());
+    mOut.write("\r\n"
+               "70\r\n"
+               "1\r\n" // closed
+               "43\r\n"
+               "0.0\r\n");
+    for(auto& p : poly) {
+        mOut.write("10\r\n");
+        mOut.writeFixed(p.X * scale);
+        mOut.write("\r\n20\r\n");
+        mOut.writeFixed(p.Y * scale);
+        mOut.write("\r\n");
+    }
+    mOut.write("0\r\n");
+}
+
+void cDXFWriter::arc(const sArcSegment& s)
+{
+    if(s.dir == 0) {
+        line(s.x0, s.y0, 0, s.x1, s.y1, 0);
+        return;
+    }
+
+    // dxf arcs always run counter clockwise
+    double a0 = qRadiansToDegrees(std::atan2(s.y0 - s.cy, s.x0 - s.cx));
+    double a1 = qRadiansToDegrees(std::atan2(s.y1 - s.cy, s.x1 - s.cx));
+    if(s.dir < 0) std::swap(a0, a1);
+    if(a0 < 0) a0 += 360.0;
+    if(a1 < 0) a1 += 360.0;
+
+    entity("ARC", "AcDbCircle");
+    mOut.write("10\r\n");
+    mOut.writeFixed(s.cx);
+    mOut.write("\r\n20\r\n");
+    mOut.writeFixed(s.cy);
+    mOut.write("\r\n30\r\n"
+               "0.0\r\n"
+               "40\r\n");
+    mOut.writeFixed(s.r);
+    mOut.write("\r\n"
+               "100\r\n"
+               "AcDbArc\r\n"
+               "50\r\n");
+    mOut.writeFixed(a0);
+    mOut.write("\r\n51\r\n");
+    mOut.writeFixed(a1);
+    mOut.write("\r\n0\r\n");
+}
+
+void cDXFWriter::spline(const std::vector<QVector2D>& ctrl)
+{
+    if(ctrl.size() < 4 || (ctrl.size() - 1) % 3) return;
+
+    size_t segments = (ctrl.size() - 1) / 3;
+
+    entity("SPLINE", "AcDbSpline");
+    mOut.write("210\r\n"
+               "0.0\r\n"
+               "220\r\n"
+               "0.0\r\n"
+               "230\r\n"
+               "1.0\r\n"
+               "70\r\n"
+               "8\r\n" // planar
+               "71\r\n"
+               "3\r\n"
+               "72\r\n");
+    mOut.writeInt(ctrl.size() + 4);
+    mOut.write("\r\n73\r\n");
+    mOut.writeInt(ctrl.size());
+    mOut.write("\r\n"
+               "74\r\n"
+               "0\r\n"
+               "42\r\n"
+               "0.0000001\r\n"
+               "43\r\n"
+               "0.0000001\r\n");
+
+    // 0 0 0 0 1 1 1 2 2 2 ... n n n n
+    for(size_t k=0; k<ctrl.size()+4; k++) {
+        mOut.write("40\r\n");
+        mOut.writeInt(k < 4 ? 0 : std::min((k - 1) / 3, segments));
+        mOut.write("\r\n");
+    }
+
+    for(auto& p : ctrl) {
+        mOut.write("10\r\n");
+        mOut.writeFixed(p.x());
+        mOut.write("\r\n20\r\n");
+        mOut.writeFixed(p.y());
+        mOut.write("\r\n30\r\n"
+                   "0.0\r\n");
+    }
+    mOut.write("0\r\n");
+}
+
+void cDXFWriter::arcs(const Path& poly, double scale, double tolerance)
+{
+    fitBiarcs(poly, scale, tolerance, mSegments);
+    for(auto& s : mSegments)
+        arc(s);
+}
+
+void cDXFWriter::outline(const Path& poly, double scale, OutlineMode mode, double tolerance)
+{
+    switch(mode) {
+    case omLines: polygon(poly, scale); break;
+    case omPolyline: polyline(poly, scale); break;
+    case omArcs: arcs(poly, scale, tolerance); break;
+    case omSpline: polyline(poly, scale); break; // sampled outlines have no exact spline
+    default: polygon(poly, scale); break; // out of range, as omLines
+    }
+}
+
+bool writeDXF(const QString& fname, const Paths& polys, double scale, OutlineMode mode, double tolerance, const std::vector<QVector2D>& pitch)
+{
+    cDXFWriter dxf;
+    if(!dxf.open(fname)) return false;
+    if(pitch.size()) {
+        dxf.spline(pitch);
+    } else {
+        for(auto& poly : polys)
+            dxf.outline(poly, scale, mode, tolerance);
+    }
+    return dxf.close();
+}
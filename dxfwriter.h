@@ -0,0 +1,55 @@
+#ifndef DXFWRITER_H
+#define DXFWRITER_H
+
+#include "bufferedwriter.h"
+
+#include <QVector2D>
+#include "clipper.h"
+#include "biarc.h"
+
+using namespace ClipperLib;
+
+// how a closed outline ends up in the file, the order matches the ui combo box
+enum OutlineMode { omLines, omPolyline, omArcs, omSpline };
+
+// streams the dxf1.txt header, the entities and the dxf2.txt footer through
+// a single cBufferedWriter
+class cDXFWriter
+{
+public:
+    bool open(const QString& fname);
+    bool close();
+
+    void line(double x1, double y1, double z1, double x2, double y2, double z2);
+
+    // closed outline, clipper units are multiplied by scale
+    void polygon(const Path& poly, double scale);
+
+    // the same outline as a single closed LWPOLYLINE entity
+    void polyline(const Path& poly, double scale);
+
+    // biarc fit within tolerance, written as ARC and LINE entities
+    void arcs(const Path& poly, double scale, double tolerance);
+
+    void arc(const sArcSegment& s);
+
+    // piecewise cubic bezier given as 3n+1 control points, written as one
+    // clamped B-spline with triple interior knots so the shape stays exact
+    void spline(const std::vector<QVector2D>& ctrl);
+
+    void outline(const Path& poly, double scale, OutlineMode mode, double tolerance);
+
+private:
+    void handle();
+    void entity(const char* name, const char* subclass);
+
+    cBufferedWriter mOut;
+    int mId = 115;
+    std::vector<sArcSegment> mSegments;
+};
+
+// a whole file in one go, a non empty pitch bezier replaces the outlines
+// with the exact spline
+bool writeDXF(const QString& fname, const Paths& polys, double scale, OutlineMode mode, double tolerance, const std::vector<QVector2D>& pitch = std::vector<QVector2D>());
+
+#endif // DXFWRITER_H
@@ -0,0 +1,65 @@
+#include "exporter.h"
+#include "bufferedwriter.h"
+
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#include <QProgressDialog>
+#include <QMessageBox>
+
+static void runExport(sExportJob& job)
+{
+    if(job.cancel->load()) return;
+    cBufferedWriter::setCancelFlag(job.cancel.get());
+    job.ok = job.write();
+    cBufferedWriter::setCancelFlag(nullptr);
+}
+
+void runExports(QWidget* parent, const QString& title, const QString& done, std::vector<sExportJob> jobs)
+{
+    if(jobs.empty()) return;
+
+    // the batch lives until the watcher reports that it is finished
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    auto batch = std::make_shared<std::vector<sExportJob>>(std::move(jobs));
+    for(auto& job : *batch) job.cancel = cancel;
+
+    QProgressDialog* progress = new QProgressDialog(title, QObject::tr("Cancel"), 0, int(batch->size()), parent);
+    progress->setWindowModality(Qt::NonModal);
+    progress->setMinimumDuration(500);
+    progress->setValue(0);
+
+    QFutureWatcher<void>* watcher = new QFutureWatcher<void>(parent);
+    QObject::connect(watcher, &QFutureWatcherBase::progressValueChanged, progress, &QProgressDialog::setValue);
+    QObject::connect(progress, &QProgressDialog::canceled, watcher, [cancel, watcher]() {
+        cancel->store(true);
+        watcher->cancel();
+    });
+    QObject::connect(watcher, &QFutureWatcherBase::finished, parent, [=]() {
+        progress->deleteLater();
+        watcher->deleteLater();
+
+        // jobs that finished before the cancel have committed their files
+        if(cancel->load()) {
+            QStringList written;
+            for(auto& job : *batch)
+                if(job.ok) written.append(job.fname);
+
+            if(written.size())
+                QMessageBox::information(parent, title, QObject::tr("Export cancelled, only %1 was written.").arg(written.join(", ")));
+            else
+                QMessageBox::information(parent, title, QObject::tr("Export cancelled, nothing was overwritten."));
+            return;
+        }
+
+        QStringList failed;
+        for(auto& job : *batch)
+            if(!job.ok) failed.append(job.fname);
+
+        if(failed.size())
+            QMessageBox::warning(parent, "Error", "Could not write " + failed.join(", "));
+        else
+            QMessageBox::information(parent, "Success", done);
+    });
+
+    watcher->setFuture(QtConcurrent::map(*batch, runExport));
+}
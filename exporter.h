@@ -0,0 +1,27 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <QString>
+#include <QWidget>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct sExportJob
+{
+    sExportJob(const QString& fname, std::function<bool()> write) : fname(fname), write(write) {}
+
+    QString fname;
+    std::function<bool()> write; // runs on a pool thread, works on its own copies only
+    std::shared_ptr<std::atomic<bool>> cancel;
+    bool ok = false;
+};
+
+// runs the jobs on the global thread pool behind a non modal progress dialog
+// with a cancel button, so several batches can run side by side, and reports
+// the outcome when the last job is done
+void runExports(QWidget* parent, const QString& title, const QString& done, std::vector<sExportJob> jobs);
+
+#endif // EXPORTER_H
@@ -0,0 +1,296 @@
+#include "extrude.h"
+#include "triangulate.h"
+#include "bufferedwriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+struct sLayer
+{
+    double z;
+    double si, co; // twist at this height
+    bool inset;    // chamfered ring
+};
+
+struct sVertex
+{
+    float x, y, z;
+};
+
+class cExtruder
+{
+public:
+    cExtruder(const Paths& outlines, double scale, const sExtrudeParams& params);
+
+    bool write(const QString& fname);
+
+private:
+    sVertex vertex(size_t ring, size_t i, const sLayer& layer) const;
+    void insetRings(double chamfer, Paths& inset) const;
+    bool triangulateCaps(const Paths& rings, std::vector<size_t>& caps) const;
+    bool capsCover(const Paths& rings, const std::vector<size_t>& caps) const;
+    bool insetIsSimple(double chamfer) const;
+    double limitChamfer(double chamfer) const;
+    void triangle(const sVertex& a, const sVertex& b, const sVertex& c);
+
+    Paths mRings;
+    std::vector<size_t> mRingStart;     // global id of the first vertex of every ring
+    std::vector<size_t> mGroupStart;    // first ring of every outer contour, and the end
+    std::vector<double> mInsetX, mInsetY; // chamfer offset of every vertex, mm
+    std::vector<size_t> mCaps;          // global vertex ids, counter clockwise
+    bool mCapsValid = true;             // every hole was bridged
+    std::vector<std::pair<size_t, size_t>> mVertexRing;
+    std::vector<sLayer> mLayers;
+    double mScale;
+    cBufferedWriter mOut;
+};
+
+cExtruder::cExtruder(const Paths& outlines, double scale, const sExtrudeParams& params) : mScale(scale)
+{
+    // let clipper sort out overlaps and which contour is a hole of which
+    Clipper c;
+    c.AddPaths(outlines, ptSubject, true);
+    PolyTree tree;
+    c.Execute(ctUnion, tree, pftNonZero, pftNonZero);
+
+    size_t first = 0;
+    for(PolyNode* node = tree.GetFirst(); node; node = node->GetNext()) {
+        if(node->IsHole()) continue;
+
+        mGroupStart.push_back(mRings.size());
+        mRingStart.push_back(first);
+        first += node->Contour.size();
+        mRings.push_back(node->Contour);
+        for(auto child : node->Childs) {
+            mRingStart.push_back(first);
+            first += child->Contour.size();
+            mRings.push_back(child->Contour);
+        }
+    }
+    mGroupStart.push_back(mRings.size());
+
+    // chamfer along the miter of every vertex, towards the material which is
+    // on the left of both outer contours and holes, first for 1 mm
+    for(auto& ring : mRings) {
+        size_t n = ring.size();
+        for(size_t i=0; i<n; i++) {
+            const IntPoint& p = ring[(i+n-1)%n];
+            const IntPoint& q = ring[i];
+            const IntPoint& r = ring[(i+1)%n];
+            double ax = double(q.X - p.X), ay = double(q.Y - p.Y);
+            double bx = double(r.X - q.X), by = double(r.Y - q.Y);
+            double la = std::hypot(ax, ay), lb = std::hypot(bx, by);
+            if(la > 0) { ax /= la; ay /= la; }
+            if(lb > 0) { bx /= lb; by /= lb; }
+            // the bisector of the edge normals is 2cos(half angle) long, the
+            // miter grows with its inverse and is capped at sharp spikes
+            double mx = -(ay + by), my = ax + bx;
+            double ml = std::hypot(mx, my);
+            double f = ml > 0.5 ? 2.0 / (ml * ml) : (ml > 0 ? 4.0 / ml : 0.0);
+            mInsetX.push_back(mx * f);
+            mInsetY.push_back(my * f);
+        }
+    }
+
+    double chamfer = limitChamfer(std::min(params.chamfer, params.thickness / 2));
+
+    // the caps sit on the inset rings when chamfered, so those are the ones
+    // triangulated, the same vertices in the same order as the outline
+    if(chamfer > 0) {
+        Paths inset;
+        insetRings(chamfer, inset);
+        mCapsValid = triangulateCaps(inset, mCaps);
+    }
+    else mCapsValid = triangulateCaps(mRings, mCaps);
+
+    for(auto& v : mInsetX) v *= chamfer;
+    for(auto& v : mInsetY) v *= chamfer;
+
+    // rings from bottom to top, the chamfer rings are inset at the caps
+    std::vector<std::pair<double, bool>> zs;
+    double z0 = chamfer, z1 = params.thickness - chamfer;
+    if(chamfer > 0) zs.push_back(std::make_pair(0.0, true));
+    int steps = params.twist ? std::max(1, int(std::ceil(std::fabs(params.twist) / std::max(params.twistStep, 0.01)))) : 1;
+    for(int i=0; i<=steps; i++)
+        zs.push_back(std::make_pair(z0 + (z1 - z0) * i / steps, false));
+    if(chamfer > 0) zs.push_back(std::make_pair(params.thickness, true));
+
+    for(auto& z : zs) {
+        double a = params.thickness > 0 ? params.twist * 3.14159265358979323846 / 180.0 * z.first / params.thickness : 0.0;
+        mLayers.push_back({ z.first, std::sin(a), std::cos(a), z.second });
+    }
+}
+
+// the rings moved along the unit miters by chamfer mm, in clipper units
+void cExtruder::insetRings(double chamfer, Paths& inset) const
+{
+    inset.assign(mRings.size(), Path());
+    for(size_t r=0; r<mRings.size(); r++) {
+        for(size_t i=0; i<mRings[r].size(); i++) {
+            size_t k = mRingStart[r] + i;
+            inset[r] << IntPoint(std::llround(mRings[r][i].X + mInsetX[k] * chamfer / mScale),
+                                 std::llround(mRings[r][i].Y + mInsetY[k] * chamfer / mScale));
+        }
+    }
+}
+
+// global vertex ids of the cap triangles of every outer contour with its
+// holes, false if a hole could not be bridged
+bool cExtruder::triangulateCaps(const Paths& rings, std::vector<size_t>& caps) const
+{
+    caps.clear();
+    bool bridged = true;
+    std::vector<size_t> tris;
+    Paths group;
+    for(size_t g=0; g+1<mGroupStart.size(); g++) {
+        group.assign(rings.begin() + mGroupStart[g], rings.begin() + mGroupStart[g+1]);
+        if(!triangulate(group, tris)) bridged = false;
+        for(auto id : tris) caps.push_back(mRingStart[mGroupStart[g]] + id);
+    }
+    return bridged;
+}
+
+// nearly touching rings can leave the ear clipper with forced corners, the
+// triangles then overlap or turn over instead of tiling the rings
+bool cExtruder::capsCover(const Paths& rings, const std::vector<size_t>& caps) const
+{
+    std::vector<const IntPoint*> points;
+    double expected = 0;
+    for(auto& r : rings) {
+        for(auto& p : r) points.push_back(&p);
+        expected += Area(r);
+    }
+
+    double area = 0;
+    for(size_t t=0; t<caps.size(); t+=3) {
+        const IntPoint& a = *points[caps[t]];
+        const IntPoint& b = *points[caps[t+1]];
+        const IntPoint& c = *points[caps[t+2]];
+        double twice = double(b.X - a.X) * double(c.Y - a.Y) - double(b.Y - a.Y) * double(c.X - a.X);
+        if(twice < 0) return false;
+        area += twice / 2;
+    }
+    return std::fabs(area - expected) <= 1e-6 * std::fabs(expected);
+}
+
+// the side walls and caps join the inset rings vertex by vertex, so they must
+// not fold over themselves or run into each other, and the inset rings must
+// still triangulate into caps that cover them
+bool cExtruder::insetIsSimple(double chamfer) const
+{
+    Paths inset;
+    insetRings(chamfer, inset);
+    double area = 0;
+    for(auto& r : inset) area += Area(r);
+
+    // a folded corner is a loop of its own that the signed area subtracts
+    Paths simple;
+    SimplifyPolygons(inset, simple, pftNonZero);
+    double simpleArea = 0;
+    for(auto& p : simple) simpleArea += Area(p);
+    if(simple.size() != inset.size() || std::fabs(simpleArea - area) > 1e-6 * std::fabs(area)) return false;
+
+    std::vector<size_t> caps;
+    return triangulateCaps(inset, caps) && capsCover(inset, caps);
+}
+
+// thin teeth collapse long before half the thickness is reached, the
+// chamfer is cut back to the largest inset that still keeps the rings simple
+double cExtruder::limitChamfer(double chamfer) const
+{
+    if(chamfer <= 0 || insetIsSimple(chamfer)) return std::max(chamfer, 0.0);
+
+    double lo = 0, hi = chamfer;
+    for(int i=0; i<20; i++) {
+        double mid = (lo + hi) / 2;
+        if(insetIsSimple(mid)) lo = mid;
+        else hi = mid;
+    }
+    return lo;
+}
+
+sVertex cExtruder::vertex(size_t ring, size_t i, const sLayer& layer) const
+{
+    double x = mRings[ring][i].X * mScale, y = mRings[ring][i].Y * mScale;
+    if(layer.inset) {
+        x += mInsetX[mRingStart[ring] + i];
+        y += mInsetY[mRingStart[ring] + i];
+    }
+    return { float(layer.co * x - layer.si * y), float(layer.si * x + layer.co * y), float(layer.z) };
+}
+
+void cExtruder::triangle(const sVertex& a, const sVertex& b, const sVertex& c)
+{
+    float ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+    float vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+    float n[3] = { uy * vz - uz * vy, uz * vx - ux * vz, ux * vy - uy * vx };
+    float l = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if(l > 0) { n[0] /= l; n[1] /= l; n[2] /= l; }
+
+    // normal, three vertices and a zero attribute, little endian like every
+    // platform we ship on
+    char rec[50];
+    memcpy(rec, n, 12);
+    memcpy(rec + 12, &a, 12);
+    memcpy(rec + 24, &b, 12);
+    memcpy(rec + 36, &c, 12);
+    rec[48] = rec[49] = 0;
+    mOut.write(rec, 50);
+}
+
+bool cExtruder::write(const QString& fname)
+{
+    // an unbridged hole would be covered by the caps
+    if(!mCapsValid) return false;
+
+    size_t vertices = 0;
+    for(auto& r : mRings) vertices += r.size();
+
+    unsigned count = unsigned(mCaps.size() / 3 * 2 + vertices * 2 * (mLayers.size() - 1));
+
+    if(!mOut.open(fname)) return false;
+
+    char header[80] = "Gearszki binary STL";
+    mOut.write(header, 80);
+    mOut.write(reinterpret_cast<const char*>(&count), 4);
+
+    // ring and index of every global vertex id for the caps
+    mVertexRing.clear();
+    for(size_t r=0; r<mRings.size(); r++)
+        for(size_t i=0; i<mRings[r].size(); i++)
+            mVertexRing.push_back(std::make_pair(r, i));
+
+    const sLayer& bottom = mLayers.front();
+    const sLayer& top = mLayers.back();
+    for(size_t t=0; t<mCaps.size(); t+=3) {
+        auto a = mVertexRing[mCaps[t]], b = mVertexRing[mCaps[t+1]], c = mVertexRing[mCaps[t+2]];
+        triangle(vertex(a.first, a.second, bottom), vertex(c.first, c.second, bottom), vertex(b.first, b.second, bottom));
+        triangle(vertex(a.first, a.second, top), vertex(b.first, b.second, top), vertex(c.first, c.second, top));
+    }
+
+    for(size_t l=0; l+1<mLayers.size(); l++) {
+        for(size_t r=0; r<mRings.size(); r++) {
+            size_t n = mRings[r].size();
+            for(size_t i=0; i<n; i++) {
+                size_t j = i+1; if(j==n) j=0;
+                sVertex al = vertex(r, i, mLayers[l]), bl = vertex(r, j, mLayers[l]);
+                sVertex au = vertex(r, i, mLayers[l+1]), bu = vertex(r, j, mLayers[l+1]);
+                triangle(al, bl, bu);
+                triangle(al, bu, au);
+            }
+        }
+    }
+
+    return mOut.close();
+}
+
+}
+
+bool writeSTL(const QString& fname, const Paths& outlines, double scale, const sExtrudeParams& params)
+{
+    cExtruder extruder(outlines, scale, params);
+    return extruder.write(fname);
+}
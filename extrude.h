@@ -0,0 +1,23 @@
+#ifndef EXTRUDE_H
+#define EXTRUDE_H
+
+#include "clipper.h"
+
+#include <QString>
+
+using namespace ClipperLib;
+
+struct sExtrudeParams
+{
+    double thickness = 10.0; // mm
+    double twist = 0.0;      // degrees from bottom to top, helical gears
+    double chamfer = 0.0;    // mm, top and bottom edges
+    double twistStep = 1.0;  // degrees of twist per layer of side walls
+};
+
+// extrudes the area covered by the outlines (clipper units, multiplied by
+// scale) and streams it as binary STL, only the rings and the cap
+// triangulation are kept in memory, the side walls are generated on the fly
+bool writeSTL(const QString& fname, const Paths& outlines, double scale, const sExtrudeParams& params);
+
+#endif // EXTRUDE_H
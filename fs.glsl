@@ -1,10 +1,10 @@
 #version 430
 
-uniform vec4 qt_lineColor;
+in vec4 color;
 
 out vec4 fragColor;
 
 void main()
 {
-    fragColor = qt_lineColor;
+    fragColor = color;
 }
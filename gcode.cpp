@@ -0,0 +1,158 @@
+#include "gcode.h"
+#include "biarc.h"
+#include "bufferedwriter.h"
+
+#include <algorithm>
+#include <cmath>
+
+struct sToolpath
+{
+    std::vector<sArcSegment> segments;
+    bool hole;
+};
+
+static void tangentAt(const sArcSegment& s, bool end, double& tx, double& ty)
+{
+    double x = end ? s.x1 : s.x0, y = end ? s.y1 : s.y0;
+    if(s.dir == 0) {
+        tx = s.x1 - s.x0;
+        ty = s.y1 - s.y0;
+    } else {
+        tx = -(y - s.cy) * s.dir;
+        ty = (x - s.cx) * s.dir;
+    }
+    double l = std::sqrt(tx * tx + ty * ty);
+    if(l > 0) { tx /= l; ty /= l; }
+}
+
+static void axis(cBufferedWriter& out, const char* word, double v)
+{
+    out.write(word);
+    out.writeFixed(v, 4);
+}
+
+static void move(cBufferedWriter& out, const char* g, double x, double y)
+{
+    out.write(g);
+    axis(out, " X", x);
+    axis(out, " Y", y);
+}
+
+static void plunge(cBufferedWriter& out, double z, double feed)
+{
+    axis(out, "G1 Z", z);
+    axis(out, " F", feed);
+    out.write("\n");
+}
+
+static void cut(cBufferedWriter& out, const sToolpath& tp, double leadX, double leadY, double z, const sGCodeParams& params)
+{
+    const sArcSegment& first = tp.segments.front();
+
+    plunge(out, z, params.plungeFeed);
+    move(out, "G1", first.x0, first.y0);
+    axis(out, " F", params.feed);
+    out.write("\n");
+
+    for(auto& s : tp.segments) {
+        if(s.dir == 0) {
+            move(out, "G1", s.x1, s.y1);
+        } else {
+            move(out, s.dir > 0 ? "G3" : "G2", s.x1, s.y1);
+            axis(out, " I", s.cx - s.x0);
+            axis(out, " J", s.cy - s.y0);
+        }
+        out.write("\n");
+    }
+
+    move(out, "G1", leadX, leadY);
+    out.write("\n");
+}
+
+bool writeGCode(const QString& fname, const Paths& toolpaths, double scale, const sGCodeParams& params)
+{
+    std::vector<sToolpath> paths;
+    Path reversed;
+    for(auto& path : toolpaths) {
+        if(path.size() < 3) continue;
+
+        // climb milling with a clockwise spindle runs outer contours clockwise
+        // and holes counter clockwise, the reverse of clipper's orientation
+        sToolpath tp;
+        tp.hole = !Orientation(path);
+        reversed.assign(path.rbegin(), path.rend());
+
+        if(params.arcTolerance > 0) {
+            fitBiarcs(reversed, scale, params.arcTolerance, tp.segments);
+        } else {
+            for(size_t i=0; i<reversed.size(); i++) {
+                size_t j=i+1; if(j==reversed.size()) j=0;
+                tp.segments.push_back({ reversed[i].X * scale, reversed[i].Y * scale, reversed[j].X * scale, reversed[j].Y * scale, 0, 0, 0, 0 });
+            }
+        }
+        if(tp.segments.size()) paths.push_back(tp);
+    }
+
+    cBufferedWriter out;
+    if(!out.open(fname)) return false;
+
+    out.write("(Gearszki)\nG21\nG90\nG17\n");
+    axis(out, "G0 Z", params.safeZ);
+    out.write("\nM3 S");
+    out.writeInt(std::llround(params.spindle));
+    out.write("\n");
+
+    int passes = std::max(1, int(std::ceil(params.depth / params.stepDown - 1e-9)));
+
+    double x = 0.0, y = 0.0;
+    std::vector<bool> done(paths.size());
+    for(int group=0; group<2; group++) {
+        for(;;) {
+            // nearest unvisited toolpath entry from the current position
+            size_t bestPath = paths.size(), bestSeg = 0;
+            double bestDist = 0;
+            for(size_t i=0; i<paths.size(); i++) {
+                if(done[i] || paths[i].hole != (group == 0)) continue;
+                for(size_t k=0; k<paths[i].segments.size(); k++) {
+                    const sArcSegment& s = paths[i].segments[k];
+                    double d = (s.x0 - x) * (s.x0 - x) + (s.y0 - y) * (s.y0 - y);
+                    if(bestPath == paths.size() || d < bestDist) {
+                        bestPath = i;
+                        bestSeg = k;
+                        bestDist = d;
+                    }
+                }
+            }
+            if(bestPath == paths.size()) break;
+            done[bestPath] = true;
+
+            sToolpath& tp = paths[bestPath];
+            std::rotate(tp.segments.begin(), tp.segments.begin() + bestSeg, tp.segments.end());
+
+            // the lead sits off the entry point on the side away from the material
+            double tx0, ty0, tx1, ty1;
+            tangentAt(tp.segments.back(), true, tx1, ty1);
+            tangentAt(tp.segments.front(), false, tx0, ty0);
+            double nx = -(ty0 + ty1), ny = tx0 + tx1;
+            double nl = std::sqrt(nx * nx + ny * ny);
+            if(nl > 0) { nx /= nl; ny /= nl; }
+            double leadX = tp.segments.front().x0 + nx * params.leadLength;
+            double leadY = tp.segments.front().y0 + ny * params.leadLength;
+
+            axis(out, "G0 Z", params.safeZ);
+            out.write("\n");
+            move(out, "G0", leadX, leadY);
+            out.write("\n");
+
+            for(int pass=1; pass<=passes; pass++)
+                cut(out, tp, leadX, leadY, -std::min(params.depth, pass * params.stepDown), params);
+
+            x = leadX;
+            y = leadY;
+        }
+    }
+
+    axis(out, "G0 Z", params.safeZ);
+    out.write("\nM5\nG0 X0 Y0\nM30\n");
+    return out.close();
+}
@@ -0,0 +1,28 @@
+#ifndef GCODE_H
+#define GCODE_H
+
+#include "clipper.h"
+
+#include <QString>
+
+using namespace ClipperLib;
+
+struct sGCodeParams
+{
+    double toolDiameter = 3.175; // mm
+    double depth = 5.0;          // total cut depth, mm
+    double stepDown = 1.0;       // depth per pass, mm
+    double safeZ = 5.0;          // rapid moves above the stock, mm
+    double leadLength = 1.0;     // straight lead-in/out off the contour, mm
+    double feed = 1000.0;        // mm/min
+    double plungeFeed = 250.0;   // mm/min
+    double spindle = 18000.0;    // rpm
+    double arcTolerance = 0.01;  // biarc fit for G2/G3, 0 writes G1 moves only
+};
+
+// writes a milling program for toolpaths that are already offset by the tool
+// radius (clipper units, multiplied by scale), holes are cut before the outer
+// contours and each group is ordered nearest neighbour first to keep rapids short
+bool writeGCode(const QString& fname, const Paths& toolpaths, double scale, const sGCodeParams& params);
+
+#endif // GCODE_H
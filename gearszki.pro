@@ -1,4 +1,4 @@
-QT       += core gui opengl openglextensions multimedia
+QT       += core gui opengl openglextensions multimedia concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -23,15 +23,43 @@ SOURCES += \
     main.cpp \
     clipper.cpp \
     dialog.cpp \
+    polyclip.cpp \
+    offset.cpp \
+    bufferedwriter.cpp \
+    dxfwriter.cpp \
+    dxfreader.cpp \
+    biarc.cpp \
+    gcode.cpp \
+    triangulate.cpp \
+    extrude.cpp \
+    svgwriter.cpp \
+    project.cpp \
+    exporter.cpp \
     cglwidget.cpp \
+    glbufferpool.cpp \
+    outlinelod.cpp \
     svg.cpp \
     utils.cpp
 
 HEADERS += \
     bounds2d.h \
     dialog.h \
+    polyclip.h \
+    offset.h \
+    bufferedwriter.h \
+    dxfwriter.h \
+    dxfreader.h \
+    biarc.h \
+    gcode.h \
+    triangulate.h \
+    extrude.h \
+    svgwriter.h \
+    project.h \
+    exporter.h \
     clipper.h \
     cglwidget.h \
+    glbufferpool.h \
+    outlinelod.h \
     svg.h \
     utils.h
 
@@ -0,0 +1,61 @@
+#include "glbufferpool.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const int minCapacity = 1 << 20;
+
+cGLBufferPool::cGLBufferPool() : mBuffer(QOpenGLBuffer::VertexBuffer)
+{
+    mBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+}
+
+void cGLBufferPool::clear()
+{
+    if(mStaging.size()) mDirty = true;
+    mStaging.clear();
+}
+
+int cGLBufferPool::add(const void* data, int size)
+{
+    int offset = int(mStaging.size());
+    if(size > 0) {
+        mStaging.resize(mStaging.size() + size_t(size));
+        memcpy(mStaging.data() + offset, data, size_t(size));
+        mDirty = true;
+    }
+    return offset;
+}
+
+bool cGLBufferPool::bind()
+{
+    if(mStaging.empty()) return false;
+
+    if(!mBuffer.isCreated() && !mBuffer.create()) return false;
+    mBuffer.bind();
+
+    if(mDirty) {
+        int size = int(mStaging.size());
+        if(size > mCapacity)
+            mCapacity = std::max(std::max(size, mCapacity * 2), minCapacity);
+
+        // orphaning lets the driver hand out fresh storage instead of
+        // waiting for draws still reading the old contents
+        mBuffer.allocate(nullptr, mCapacity);
+        mBuffer.write(0, mStaging.data(), size);
+        mDirty = false;
+    }
+    return true;
+}
+
+void cGLBufferPool::release()
+{
+    mBuffer.release();
+}
+
+void cGLBufferPool::destroy()
+{
+    mBuffer.destroy();
+    mCapacity = 0;
+    mDirty = mStaging.size() > 0;
+}
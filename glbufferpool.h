@@ -0,0 +1,38 @@
+#ifndef GLBUFFERPOOL_H
+#define GLBUFFERPOOL_H
+
+#include <QOpenGLBuffer>
+
+#include <vector>
+
+// one large vertex buffer handing out sub-ranges. Ranges are collected on
+// the CPU side and go up in a single write the next time the pool is bound,
+// the GL buffer is orphaned on every upload and only ever grows, so no GL
+// objects are created or destroyed while the scene changes
+class cGLBufferPool
+{
+public:
+    cGLBufferPool();
+
+    // forgets the ranges, keeps the storage on both sides
+    void clear();
+
+    // appends a range and returns its byte offset in the buffer
+    int add(const void* data, int size);
+
+    int size() const { return int(mStaging.size()); }
+
+    // uploads if anything changed since the last bind, false if empty,
+    // needs a current context
+    bool bind();
+    void release();
+    void destroy();
+
+private:
+    QOpenGLBuffer mBuffer;
+    std::vector<char> mStaging;
+    int mCapacity = 0; // bytes allocated on the GPU
+    bool mDirty = false;
+};
+
+#endif // GLBUFFERPOOL_H
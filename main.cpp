@@ -1,6 +1,9 @@
 #include <QApplication>
 #include <QSurfaceFormat>
 #include <QFont>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
 
 #include "dialog.h"
 
@@ -16,11 +19,51 @@ int main(int argc, char *argv[])
     QSurfaceFormat::setDefaultFormat(format);
 
     QApplication a(argc, argv);
+
+    // batch rendering for thumbnails and animations, nothing is shown. On a
+    // box without a display run it under xvfb-run with Mesa's software
+    // rasterizer, or on an EGL platform plugin with surfaceless contexts
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument("projects", "Gearszki projects to render with --output.", "[projects...]");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Render the projects to PNG files in <directory> without opening the window.", "directory");
+    QCommandLineOption sizeOption(QStringList() << "s" << "size", "Image size, 512x512 by default.", "WxH", "512x512");
+    QCommandLineOption framesOption(QStringList() << "f" << "frames", "Frames of the meshing gears to render per project.", "n", "0");
+    parser.addOption(outputOption);
+    parser.addOption(sizeOption);
+    parser.addOption(framesOption);
+    parser.process(a);
+
     Dialog w;
 
     w.setFont(QFont("Source Code Pro", 10));
     w.setWindowFlags(Qt::Window);
 
+    if(parser.isSet(outputOption)) {
+        QStringList wh = parser.value(sizeOption).split('x');
+        QSize size = wh.size() == 2 ? QSize(wh[0].toInt(), wh[1].toInt()) : QSize();
+        if(size.isEmpty()) {
+            qCritical() << "Invalid image size" << parser.value(sizeOption);
+            return 1;
+        }
+
+        QDir dir(parser.value(outputOption));
+        if(!dir.mkpath(".")) {
+            qCritical() << "Could not create" << dir.path();
+            return 1;
+        }
+
+        int failed = 0;
+        for(auto& fname : parser.positionalArguments()) {
+            QString base = dir.filePath(QFileInfo(fname).completeBaseName());
+            if(!w.renderProject(fname, base, size, parser.value(framesOption).toInt())) {
+                qCritical() << "Could not render" << fname;
+                failed++;
+            }
+        }
+        return failed ? 1 : 0;
+    }
+
     w.show();
     return a.exec();
 }
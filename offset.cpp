@@ -0,0 +1,15 @@
+#include "offset.h"
+
+void offsetPaths(sOffsetJob& job)
+{
+    if(job.delta == 0.0) {
+        job.result = job.paths;
+        return;
+    }
+
+    static thread_local ClipperOffset co;
+    co.ArcTolerance = job.arcTolerance;
+    co.AddPaths(job.paths, jtRound, etClosedPolygon);
+    co.Execute(job.result, job.delta);
+    co.Clear();
+}
@@ -0,0 +1,23 @@
+#ifndef OFFSET_H
+#define OFFSET_H
+
+#include "clipper.h"
+
+using namespace ClipperLib;
+
+struct sOffsetJob
+{
+    sOffsetJob(const Paths& paths, double delta, double arcTolerance) : paths(paths), delta(delta), arcTolerance(arcTolerance) {}
+
+    Paths paths;
+    double delta; // clipper units, positive grows the outline
+    double arcTolerance; // clipper units, the mm tolerance times M
+    Paths result;
+};
+
+// offsets the job with round joins on the calling thread, the exports already
+// run on the thread pool, so each worker thread keeps its own ClipperOffset
+// and the scratch buffers are reused from call to call
+void offsetPaths(sOffsetJob& job);
+
+#endif // OFFSET_H
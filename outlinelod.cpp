@@ -0,0 +1,84 @@
+#include "outlinelod.h"
+
+#include <algorithm>
+
+// squared distance of p from the segment a-b
+static float segmentDistance2(const QVector2D& p, const QVector2D& a, const QVector2D& b)
+{
+    QVector2D ab = b - a;
+    float len2 = QVector2D::dotProduct(ab, ab);
+    float t = len2 > 0.f ? QVector2D::dotProduct(p - a, ab) / len2 : 0.f;
+    t = std::min(std::max(t, 0.f), 1.f);
+    QVector2D d = p - (a + ab * t);
+    return QVector2D::dotProduct(d, d);
+}
+
+// Douglas-Peucker on pts[first..last], with an explicit stack so long
+// straight runs cannot recurse deep
+static void simplify(const std::vector<QVector2D>& pts, size_t first, size_t last, float tolerance, std::vector<char>& keep, std::vector<std::pair<size_t, size_t>>& stack)
+{
+    float tol2 = tolerance * tolerance;
+
+    std::fill(keep.begin() + first, keep.begin() + last + 1, 0);
+    keep[first] = keep[last] = 1;
+
+    stack.clear();
+    stack.push_back(std::make_pair(first, last));
+    while(stack.size()) {
+        size_t a = stack.back().first;
+        size_t b = stack.back().second;
+        stack.pop_back();
+
+        float maxDist = 0.f;
+        size_t index = a;
+        for(size_t i=a+1; i<b; i++) {
+            float d = segmentDistance2(pts[i], pts[a], pts[b]);
+            if(d > maxDist) {
+                maxDist = d;
+                index = i;
+            }
+        }
+
+        if(maxDist > tol2) {
+            keep[index] = 1;
+            if(index - a > 1) stack.push_back(std::make_pair(a, index));
+            if(b - index > 1) stack.push_back(std::make_pair(index, b));
+        }
+    }
+}
+
+void buildOutlineLods(const std::vector<float>& loop, std::vector<QVector2D>& vertices, std::vector<sOutlineChunk>& chunks)
+{
+    size_t n = loop.size() / 2;
+    if(n < 2) return;
+
+    // closed, the first vertex repeats at the end
+    std::vector<QVector2D> pts(n + 1);
+    for(size_t i=0; i<n; i++) pts[i] = QVector2D(loop[i*2], loop[i*2+1]);
+    pts[n] = pts[0];
+
+    std::vector<char> keep(n + 1);
+    std::vector<std::pair<size_t, size_t>> stack;
+
+    for(size_t start=0; start<n; start+=outlineChunkSize) {
+        size_t end = std::min(start + outlineChunkSize, n);
+
+        sOutlineChunk c;
+        c.bounds.init();
+        for(size_t i=start; i<=end; i++) c.bounds.add(pts[i]);
+
+        for(int l=0; l<outlineLevels; l++) {
+            c.first[l] = int(vertices.size());
+            if(l == 0) {
+                vertices.insert(vertices.end(), pts.begin() + start, pts.begin() + end + 1);
+            } else {
+                simplify(pts, start, end, outlineTolerance[l], keep, stack);
+                for(size_t i=start; i<=end; i++)
+                    if(keep[i]) vertices.push_back(pts[i]);
+            }
+            c.count[l] = int(vertices.size()) - c.first[l];
+        }
+
+        chunks.push_back(c);
+    }
+}
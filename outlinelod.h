@@ -0,0 +1,30 @@
+#ifndef OUTLINELOD_H
+#define OUTLINELOD_H
+
+#include <QVector2D>
+
+#include <vector>
+
+#include "bounds2d.h"
+
+static const int outlineLevels = 5;
+static const size_t outlineChunkSize = 256;
+
+// largest deviation allowed on every level, in drawing units (mm)
+static const float outlineTolerance[outlineLevels] = { 0.f, 0.01f, 0.04f, 0.16f, 0.64f };
+
+// a run of consecutive outline vertices, drawn as a line strip, with a
+// Douglas-Peucker simplified copy per level. Both end vertices are kept on
+// every level so neighbouring chunks still join up
+struct sOutlineChunk
+{
+    Bounds2D bounds;
+    int first[outlineLevels];
+    int count[outlineLevels];
+};
+
+// splits a closed outline given as x,y pairs into chunks, the strips of all
+// levels are appended to vertices
+void buildOutlineLods(const std::vector<float>& loop, std::vector<QVector2D>& vertices, std::vector<sOutlineChunk>& chunks);
+
+#endif // OUTLINELOD_H
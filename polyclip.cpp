@@ -0,0 +1,275 @@
+#include "polyclip.h"
+
+#include <cmath>
+
+// the kernels are O(subject * clip), past this clip size Clipper's sweep wins
+static const size_t maxKernelClipSize = 64;
+
+static int sgn(cInt v)
+{
+    return (v > 0) - (v < 0);
+}
+
+static void countFlip(int s, int& first, int& last, int& flips)
+{
+    if(!s) return;
+    if(!first) first = s;
+    else if(s != last) flips++;
+    last = s;
+}
+
+bool isConvex(const Path& p)
+{
+    size_t n = p.size();
+    if(n < 3) return false;
+
+    int turn = 0;
+    int firstXs = 0, lastXs = 0, xFlips = 0;
+    int firstYs = 0, lastYs = 0, yFlips = 0;
+
+    for(size_t i=0; i<n; i++) {
+        const IntPoint& a = p[i];
+        const IntPoint& b = p[(i+1)%n];
+        const IntPoint& c = p[(i+2)%n];
+
+        // keep the cross products inside 64 bits
+        if(a.X > loRange || a.X < -loRange || a.Y > loRange || a.Y < -loRange)
+            return false;
+
+        cInt dx = b.X - a.X, dy = b.Y - a.Y;
+        int s = sgn(dx * (c.Y - b.Y) - dy * (c.X - b.X));
+        if(s) {
+            if(turn && s != turn) return false;
+            turn = s;
+        }
+
+        countFlip(sgn(dx), firstXs, lastXs, xFlips);
+        countFlip(sgn(dy), firstYs, lastYs, yFlips);
+    }
+
+    // closing the loop, a self intersecting "star" turns the same way but flips more often
+    if(lastXs != firstXs) xFlips++;
+    if(lastYs != firstYs) yFlips++;
+
+    return turn != 0 && xFlips <= 2 && yFlips <= 2;
+}
+
+static void roundToPath(const std::vector<double>& xs, const std::vector<double>& ys, Path& result)
+{
+    result.clear();
+    for(size_t i=0; i<xs.size(); i++) {
+        IntPoint ip(std::llround(xs[i]), std::llround(ys[i]));
+        if(result.empty() || result.back() != ip)
+            result.push_back(ip);
+    }
+    while(result.size() > 1 && result.front() == result.back())
+        result.pop_back();
+    if(result.size() < 3)
+        result.clear();
+}
+
+void clipConvex(const Path& subject, const Path& clip, Path& result)
+{
+    // scratch buffers are reused between calls, this runs once per rolling step
+    static thread_local std::vector<double> xs, ys, nxs, nys, d;
+
+    xs.clear();
+    ys.clear();
+    for(auto& p : subject) {
+        xs.push_back(p.X);
+        ys.push_back(p.Y);
+    }
+
+    double orient = Orientation(clip) ? 1.0 : -1.0;
+    size_t cn = clip.size();
+
+    for(size_t k=0; k<cn && xs.size(); k++) {
+        const IntPoint& a = clip[k];
+        const IntPoint& b = clip[(k+1)%cn];
+        const double ax = a.X, ay = a.Y;
+        const double ex = (b.X - a.X) * orient, ey = (b.Y - a.Y) * orient;
+
+        size_t n = xs.size();
+        d.resize(n);
+        const double* px = xs.data();
+        const double* py = ys.data();
+        double* pd = d.data();
+
+        // signed distance of every vertex to the clip edge, branch free so it vectorizes
+        for(size_t i=0; i<n; i++)
+            pd[i] = ex * (py[i] - ay) - ey * (px[i] - ax);
+
+        nxs.clear();
+        nys.clear();
+        for(size_t i=0; i<n; i++) {
+            size_t j = i+1; if(j==n) j=0;
+            if(pd[i] >= 0) {
+                nxs.push_back(px[i]);
+                nys.push_back(py[i]);
+            }
+            if((pd[i] > 0 && pd[j] < 0) || (pd[i] < 0 && pd[j] > 0)) {
+                double t = pd[i] / (pd[i] - pd[j]);
+                nxs.push_back(px[i] + (px[j] - px[i]) * t);
+                nys.push_back(py[i] + (py[j] - py[i]) * t);
+            }
+        }
+        xs.swap(nxs);
+        ys.swap(nys);
+    }
+
+    roundToPath(xs, ys, result);
+}
+
+// Subject minus a convex cutter when the subject boundary runs through the
+// cutter exactly once: the inside run is replaced by the cutter boundary
+// walked backwards. Every subject edge near the cutter gets its parametric
+// inside interval (Cyrus-Beck). Returns false if the case is not that simple.
+static bool cutConvex(const Path& subject, const Path& clip, Path& result)
+{
+    static thread_local Path s, c;
+    static thread_local std::vector<size_t> edges;
+    static thread_local std::vector<double> ax, ay, bx, by, tEnter, tLeave;
+    static thread_local std::vector<int> kEnter, kLeave;
+
+    s = subject;
+    c = clip;
+    if(!Orientation(s)) ReversePath(s);
+    if(!Orientation(c)) ReversePath(c);
+
+    size_t n = s.size(), m = c.size();
+
+    cInt minX = c[0].X, maxX = c[0].X, minY = c[0].Y, maxY = c[0].Y;
+    for(auto& p : c) {
+        minX = std::min(minX, p.X); maxX = std::max(maxX, p.X);
+        minY = std::min(minY, p.Y); maxY = std::max(maxY, p.Y);
+    }
+
+    // only the subject edges overlapping the cutter's bounding box can touch it
+    edges.clear(); ax.clear(); ay.clear(); bx.clear(); by.clear();
+    for(size_t i=0; i<n; i++) {
+        const IntPoint& p = s[i];
+        const IntPoint& q = s[(i+1)%n];
+        if(std::max(p.X, q.X) < minX || std::min(p.X, q.X) > maxX) continue;
+        if(std::max(p.Y, q.Y) < minY || std::min(p.Y, q.Y) > maxY) continue;
+        edges.push_back(i);
+        ax.push_back(p.X); ay.push_back(p.Y);
+        bx.push_back(q.X); by.push_back(q.Y);
+    }
+
+    size_t en = edges.size();
+    tEnter.assign(en, -1.0);
+    tLeave.assign(en, 2.0);
+    kEnter.assign(en, -1);
+    kLeave.assign(en, -1);
+
+    for(size_t k=0; k<m; k++) {
+        const double cx = c[k].X, cy = c[k].Y;
+        const double ex = c[(k+1)%m].X - cx, ey = c[(k+1)%m].Y - cy;
+        if(ex == 0 && ey == 0) continue;
+
+        for(size_t e=0; e<en; e++) {
+            double di = ex * (ay[e] - cy) - ey * (ax[e] - cx);
+            double dj = ex * (by[e] - cy) - ey * (bx[e] - cx);
+            if(di <= 0 && dj <= 0) {
+                tEnter[e] = 3.0; // outside this half plane, empty interval
+            } else if(di <= 0) {
+                double t = di / (di - dj);
+                if(t > tEnter[e]) { tEnter[e] = t; kEnter[e] = k; }
+            } else if(dj <= 0) {
+                double t = di / (di - dj);
+                if(t < tLeave[e]) { tLeave[e] = t; kLeave[e] = k; }
+            }
+        }
+    }
+
+    int entries = 0, exits = 0, touching = 0;
+    size_t eIn = 0, eOut = 0;
+    for(size_t e=0; e<en; e++) {
+        if(std::max(tEnter[e], 0.0) >= std::min(tLeave[e], 1.0)) continue;
+        touching++;
+        if(kEnter[e] >= 0) { entries++; eIn = e; }
+        if(kLeave[e] >= 0) { exits++; eOut = e; }
+    }
+
+    if(!entries && !exits) {
+        if(touching) {
+            result.clear(); // swallowed by the cutter
+            return true;
+        }
+        if(PointInPolygon(c[0], s) != 0)
+            return false; // the cutter would leave a hole
+        result = s;
+        return true;
+    }
+
+    if(entries != 1 || exits != 1)
+        return false;
+
+    size_t iIn = edges[eIn], iOut = edges[eOut];
+    size_t kIn = kEnter[eIn], kOut = kLeave[eOut];
+
+    // walking the cutter backwards from the entry to the exit point
+    size_t arc = (kIn + m - kOut) % m;
+    if(arc == 0) {
+        // both on the same cutter edge, fine only if the exit point comes first
+        double ex = c[(kIn+1)%m].X - c[kIn].X, ey = c[(kIn+1)%m].Y - c[kIn].Y;
+        double pin = ex * (ax[eIn] + (bx[eIn] - ax[eIn]) * tEnter[eIn]) + ey * (ay[eIn] + (by[eIn] - ay[eIn]) * tEnter[eIn]);
+        double pout = ex * (ax[eOut] + (bx[eOut] - ax[eOut]) * tLeave[eOut]) + ey * (ay[eOut] + (by[eOut] - ay[eOut]) * tLeave[eOut]);
+        if(pout >= pin) return false;
+    }
+
+    static thread_local std::vector<double> xs, ys;
+    xs.clear();
+    ys.clear();
+
+    xs.push_back(ax[eOut] + (bx[eOut] - ax[eOut]) * tLeave[eOut]);
+    ys.push_back(ay[eOut] + (by[eOut] - ay[eOut]) * tLeave[eOut]);
+
+    size_t run = (iIn + n - iOut) % n; if(run == 0) run = n;
+    for(size_t i=1; i<=run; i++) {
+        const IntPoint& p = s[(iOut + i) % n];
+        xs.push_back(p.X);
+        ys.push_back(p.Y);
+    }
+
+    xs.push_back(ax[eIn] + (bx[eIn] - ax[eIn]) * tEnter[eIn]);
+    ys.push_back(ay[eIn] + (by[eIn] - ay[eIn]) * tEnter[eIn]);
+
+    for(size_t i=0; i<arc; i++) {
+        const IntPoint& p = c[(kIn + m - i) % m];
+        xs.push_back(p.X);
+        ys.push_back(p.Y);
+    }
+
+    roundToPath(xs, ys, result);
+    return true;
+}
+
+bool polyBoolean(ClipType clipType, const Path& subject, const Path& clip, Paths& solution, PolyFillType fillType)
+{
+    bool smallClip = clip.size() <= maxKernelClipSize;
+
+    if(clipType == ctIntersection && smallClip && isConvex(subject) && isConvex(clip)) {
+        solution.resize(1);
+        clipConvex(subject, clip, solution[0]);
+        if(solution[0].empty()) solution.clear();
+        else if(!Orientation(solution[0])) ReversePath(solution[0]);
+        return true;
+    }
+
+    if(clipType == ctDifference && smallClip && subject.size() >= 3 && isConvex(clip)) {
+        solution.resize(1);
+        if(cutConvex(subject, clip, solution[0])) {
+            if(solution[0].empty()) solution.clear();
+            return true;
+        }
+    }
+
+    static thread_local Clipper c;
+    c.Clear();
+    c.AddPath(subject, ptSubject, true);
+    c.AddPath(clip, ptClip, true);
+    bool res = c.Execute(clipType, solution, fillType, fillType);
+    c.Clear();
+    return res;
+}
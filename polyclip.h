@@ -0,0 +1,20 @@
+#ifndef POLYCLIP_H
+#define POLYCLIP_H
+
+#include "clipper.h"
+
+using namespace ClipperLib;
+
+// true if the closed path is convex (collinear vertices are allowed)
+bool isConvex(const Path& p);
+
+// Sutherland-Hodgman: intersection of subject with the convex clip polygon
+void clipConvex(const Path& subject, const Path& clip, Path& result);
+
+// boolean operation of two closed paths, convex inputs are handled by the
+// Sutherland-Hodgman kernel, everything else goes through Clipper; the
+// rolling loop's cutter is the whole driver outline, hundreds of vertices and
+// not convex, so the fast path only serves library callers with small cutters
+bool polyBoolean(ClipType clipType, const Path& subject, const Path& clip, Paths& solution, PolyFillType fillType = pftNonZero);
+
+#endif // POLYCLIP_H
@@ -0,0 +1,188 @@
+#include "project.h"
+#include "bufferedwriter.h"
+
+#include <QFile>
+
+#include <cstdint>
+#include <cstring>
+
+static const char magic[4] = { 'G', 'R', 'S', 'Z' };
+static const uint32_t version = 1;
+
+// every value is written in the byte order of the machine, all supported
+// platforms are little endian
+
+namespace {
+
+class cChunkWriter
+{
+public:
+    explicit cChunkWriter(cBufferedWriter& out) : mOut(out) {}
+
+    void begin(const char* tag, size_t size)
+    {
+        mOut.write(tag, 4);
+        value(uint32_t(size));
+    }
+
+    template<class T> void value(const T& v)
+    {
+        mOut.write(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    void points(const char* tag, const std::vector<QVector2D>& pts)
+    {
+        begin(tag, pts.size() * 8);
+        for(auto& p : pts) {
+            value(p.x());
+            value(p.y());
+        }
+    }
+
+private:
+    cBufferedWriter& mOut;
+};
+
+class cChunkReader
+{
+public:
+    cChunkReader(const uchar* data, size_t size) : mData(data), mSize(size) {}
+
+    bool has(size_t n) const { return mPos + n <= mSize; }
+
+    template<class T> T value()
+    {
+        T v;
+        memcpy(&v, mData + mPos, sizeof(T));
+        mPos += sizeof(T);
+        return v;
+    }
+
+    void points(size_t size, std::vector<QVector2D>& pts)
+    {
+        pts.resize(size / 8);
+        for(auto& p : pts) {
+            float x = value<float>();
+            float y = value<float>();
+            p = QVector2D(x, y);
+        }
+    }
+
+    void skip(size_t n) { mPos += n; }
+    size_t pos() const { return mPos; }
+    void seek(size_t pos) { mPos = pos; }
+
+private:
+    const uchar* mData;
+    size_t mSize;
+    size_t mPos = 0;
+};
+
+}
+
+bool saveProject(const QString& fname, const sProject& project)
+{
+    cBufferedWriter out;
+    if(!out.open(fname)) return false;
+
+    cChunkWriter w(out);
+    out.write(magic, 4);
+    w.value(version);
+
+    w.begin("INPT", 4 * 8 + 3 * 4);
+    w.value(project.alpha);
+    w.value(project.tension);
+    w.value(project.kerf);
+    w.value(project.backlash);
+    w.value(int32_t(project.teeth));
+    w.value(int32_t(project.samples));
+    w.value(int32_t(project.gearMode));
+
+    w.points("CTRL", project.controlPoints);
+
+    if(project.importedPitch.size())
+        w.points("IMPT", project.importedPitch);
+
+    if(project.mating.size()) {
+        w.begin("CALC", 2 * 4);
+        w.value(project.centerDistance);
+        w.value(project.alignment);
+
+        w.points("PTCH", project.pitch);
+
+        w.begin("PANG", project.pitchAngles.size() * 4);
+        out.write(reinterpret_cast<const char*>(project.pitchAngles.data()), project.pitchAngles.size() * 4);
+
+        w.points("DRVR", project.driver);
+
+        w.begin("MATE", project.mating.size() * 16);
+        for(auto& p : project.mating) {
+            w.value(int64_t(p.X));
+            w.value(int64_t(p.Y));
+        }
+    }
+
+    return out.close();
+}
+
+bool loadProject(const QString& fname, sProject& project)
+{
+    QFile f(fname);
+    if(!f.open(QFile::ReadOnly)) return false;
+
+    size_t size = size_t(f.size());
+    const uchar* data = size ? f.map(0, f.size()) : nullptr;
+    if(!data) return false;
+
+    cChunkReader r(data, size);
+    if(!r.has(8) || memcmp(data, magic, 4)) return false;
+    r.skip(4);
+    if(r.value<uint32_t>() > version) return false; // written by a newer version
+
+    project = sProject();
+    while(r.has(8)) {
+        char tag[4];
+        memcpy(tag, data + r.pos(), 4);
+        r.skip(4);
+        size_t len = r.value<uint32_t>();
+        if(!r.has(len)) return false;
+        size_t next = r.pos() + len;
+
+        if(!memcmp(tag, "INPT", 4) && len >= 4 * 8 + 3 * 4) {
+            project.alpha = r.value<double>();
+            project.tension = r.value<double>();
+            project.kerf = r.value<double>();
+            project.backlash = r.value<double>();
+            project.teeth = r.value<int32_t>();
+            project.samples = r.value<int32_t>();
+            project.gearMode = r.value<int32_t>() != 0;
+        } else if(!memcmp(tag, "CTRL", 4)) {
+            r.points(len, project.controlPoints);
+        } else if(!memcmp(tag, "IMPT", 4)) {
+            r.points(len, project.importedPitch);
+        } else if(!memcmp(tag, "CALC", 4) && len >= 2 * 4) {
+            project.centerDistance = r.value<float>();
+            project.alignment = r.value<float>();
+        } else if(!memcmp(tag, "PTCH", 4)) {
+            r.points(len, project.pitch);
+        } else if(!memcmp(tag, "PANG", 4)) {
+            project.pitchAngles.resize(len / 4);
+            memcpy(project.pitchAngles.data(), data + r.pos(), project.pitchAngles.size() * 4);
+        } else if(!memcmp(tag, "DRVR", 4)) {
+            r.points(len, project.driver);
+        } else if(!memcmp(tag, "MATE", 4)) {
+            project.mating.resize(len / 16);
+            for(auto& p : project.mating) {
+                p.X = r.value<int64_t>();
+                p.Y = r.value<int64_t>();
+            }
+        }
+
+        r.seek(next);
+    }
+
+    if(project.pitchAngles.size() != project.pitch.size())
+        project.pitchAngles.assign(project.pitch.size(), 0.f);
+
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef PROJECT_H
+#define PROJECT_H
+
+#include "clipper.h"
+
+#include <QString>
+#include <QVector2D>
+
+#include <vector>
+
+using namespace ClipperLib;
+
+// everything needed to reopen a design, the calculated outlines are cached
+// so a finished calculation does not have to run again
+struct sProject
+{
+    // inputs
+    std::vector<QVector2D> controlPoints;
+    std::vector<QVector2D> importedPitch; // replaces the spline when set
+    double alpha = 0.5;
+    double tension = 0.0;
+    int teeth = 0;
+    int samples = 0;
+    bool gearMode = true;
+    double kerf = 0.0;
+    double backlash = 0.0;
+
+    // results of the calculation, empty if it did not run
+    std::vector<QVector2D> pitch; // sampled pitch polygon
+    std::vector<float> pitchAngles;
+    std::vector<QVector2D> driver; // toothed driver outline
+    Path mating;
+    float centerDistance = 0.f;
+    float alignment = 0.f;
+};
+
+// versioned chunked binary file: a header, then tagged chunks with their
+// size, readers skip the tags they do not know, the file is memory mapped
+bool saveProject(const QString& fname, const sProject& project);
+bool loadProject(const QString& fname, sProject& project);
+
+#endif // PROJECT_H
@@ -121,26 +121,6 @@ int SVG::processCMD(cSVGCmd cmd)
     }
 }
 
-std::vector<GLfloat> SVG::glFloatArray(int chr, QVector2D offset)
-{
-    std::vector<GLfloat> res;
-    for(size_t slot = 0; slot<mPoints[chr].size(); slot++)
-    {
-        for(size_t i=0; i<mPoints[chr][slot].size(); i++) {
-            size_t j=i+1; if(j==mPoints[chr][slot].size()) j=0;
-            QVector2D v1 = mPoints[chr][slot][i] + offset;
-            QVector2D v2 = mPoints[chr][slot][j] + offset;
-            res.push_back(v1.x());
-            res.push_back(v1.y());
-            res.push_back(0);
-            res.push_back(v2.x());
-            res.push_back(v2.y());
-            res.push_back(0);
-        }
-    }
-    return res;
-}
-
 void SVG::append(int chr, float x, float y)
 {
     append(chr, QVector2D(x,y));
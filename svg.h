@@ -6,7 +6,6 @@
 #include <QVector2D>
 
 #include <vector>
-#include <QtOpenGL>
 #include "bounds2d.h"
 
 class cSVGCmd
@@ -61,7 +60,6 @@ public:
     QVector2D bezier(QVector2D s, QVector2D e, QVector2D c0, QVector2D c1, const float f);
     void append(int chr, float x, float y);
     void append(int chr, QVector2D p);
-    std::vector<GLfloat> glFloatArray(int chr, QVector2D offset);
 private:
     void calcBounds(int chr);
     void translate(int chr, QVector2D v);
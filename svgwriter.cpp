@@ -0,0 +1,181 @@
+#include "svgwriter.h"
+
+#include <algorithm>
+#include <cmath>
+
+cSVGWriter::cSVGWriter(int decimals) : mDecimals(std::min(std::max(decimals, 0), 9))
+{
+    mQuantum = std::pow(10.0, mDecimals);
+    mDivisor = std::llround(mQuantum);
+}
+
+long long cSVGWriter::quantize(double v) const
+{
+    return std::llround(v * mQuantum);
+}
+
+bool cSVGWriter::open(const QString& fname, double minX, double minY, double maxX, double maxY)
+{
+    if(!mOut.open(fname)) return false;
+
+    double w = maxX - minX, h = maxY - minY;
+    mOut.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+    mOut.writeFixed(w, 3);
+    mOut.write("mm\" height=\"");
+    mOut.writeFixed(h, 3);
+    mOut.write("mm\" viewBox=\"");
+    mOut.writeFixed(minX, 3);
+    mOut.write(" ");
+    mOut.writeFixed(-maxY, 3);
+    mOut.write(" ");
+    mOut.writeFixed(w, 3);
+    mOut.write(" ");
+    mOut.writeFixed(h, 3);
+    mOut.write("\">\n");
+    return true;
+}
+
+bool cSVGWriter::close()
+{
+    mOut.write("</svg>\n");
+    return mOut.close();
+}
+
+void cSVGWriter::begin(const char* style)
+{
+    mOut.write("<path ");
+    mOut.write(style);
+    mOut.write(" d=\"");
+    mCommand = 0;
+    mNumber = false;
+}
+
+void cSVGWriter::end()
+{
+    mOut.write("\"/>\n");
+}
+
+void cSVGWriter::command(char c)
+{
+    if(c == mCommand) return;
+    mOut.write(&c, 1);
+    mCommand = c;
+    mNumber = false;
+}
+
+// shortest form: no trailing zeros, no leading zero, and a separator only
+// where the next number would otherwise run into the previous one
+void cSVGWriter::number(long long q)
+{
+    unsigned long long u = q < 0 ? 0ull - (unsigned long long)q : (unsigned long long)q;
+    unsigned long long ip = u / mDivisor, fp = u % mDivisor;
+
+    char buf[48];
+    char* p = buf;
+    if(q < 0) *p++ = '-';
+
+    if(ip || !fp) {
+        char tmp[24];
+        int len = 0;
+        do { tmp[len++] = char('0' + ip % 10); ip /= 10; } while(ip);
+        while(len) *p++ = tmp[--len];
+    }
+
+    bool dot = fp != 0;
+    if(dot) {
+        *p++ = '.';
+        for(int i=mDecimals-1; i>=0; i--) { p[i] = char('0' + fp % 10); fp /= 10; }
+        p += mDecimals;
+        while(p[-1] == '0') p--;
+    }
+
+    if(mNumber && buf[0] != '-' && !(buf[0] == '.' && mDot))
+        mOut.write(" ");
+    mOut.write(buf, p - buf);
+
+    mNumber = true;
+    mDot = dot;
+}
+
+void cSVGWriter::moveTo(long long x, long long y)
+{
+    command('M');
+    number(x);
+    number(-y);
+    mX = x;
+    mY = y;
+}
+
+void cSVGWriter::lineTo(long long x, long long y)
+{
+    long long dx = x - mX, dy = y - mY;
+    if(!dx && !dy) return;
+    if(!dy) {
+        command('h');
+        number(dx);
+    } else if(!dx) {
+        command('v');
+        number(-dy);
+    } else {
+        command('l');
+        number(dx);
+        number(-dy);
+    }
+    mX = x;
+    mY = y;
+}
+
+void cSVGWriter::path(const Path& poly, double scale, double dx, double dy, const char* style)
+{
+    if(poly.size() < 2) return;
+
+    begin(style);
+    moveTo(quantize(poly[0].X * scale + dx), quantize(poly[0].Y * scale + dy));
+    for(size_t i=1; i<poly.size(); i++)
+        lineTo(quantize(poly[i].X * scale + dx), quantize(poly[i].Y * scale + dy));
+    command('z');
+    end();
+}
+
+void cSVGWriter::bezier(const std::vector<QVector2D>& ctrl, double dx, double dy, const char* style)
+{
+    if(ctrl.size() < 4) return;
+
+    begin(style);
+    moveTo(quantize(ctrl[0].x() + dx), quantize(ctrl[0].y() + dy));
+    for(size_t i=1; i+2<ctrl.size(); i+=3) {
+        command('c');
+        long long x = 0, y = 0;
+        for(int k=0; k<3; k++) {
+            x = quantize(ctrl[i+k].x() + dx);
+            y = quantize(ctrl[i+k].y() + dy);
+            number(x - mX);
+            number(-(y - mY));
+        }
+        mX = x;
+        mY = y;
+    }
+    end();
+}
+
+void cSVGWriter::line(double x0, double y0, double x1, double y1, const char* style)
+{
+    begin(style);
+    moveTo(quantize(x0), quantize(y0));
+    lineTo(quantize(x1), quantize(y1));
+    end();
+}
+
+void cSVGWriter::text(double x, double y, double size, const QString& text)
+{
+    mOut.write("<text x=\"");
+    mOut.writeFixed(x, mDecimals);
+    mOut.write("\" y=\"");
+    mOut.writeFixed(-y, mDecimals);
+    mOut.write("\" font-size=\"");
+    mOut.writeFixed(size, mDecimals);
+    mOut.write("\" text-anchor=\"middle\">");
+    mOut.write(text.toHtmlEscaped().toUtf8());
+    mOut.write("</text>\n");
+}
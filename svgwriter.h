@@ -0,0 +1,50 @@
+#ifndef SVGWRITER_H
+#define SVGWRITER_H
+
+#include "bufferedwriter.h"
+#include "clipper.h"
+
+#include <QVector2D>
+
+using namespace ClipperLib;
+
+// writes <path> elements with relative commands through a cBufferedWriter,
+// coordinates are mm with y up, rounded to a fixed number of decimals, the
+// relative steps are taken between rounded points so nothing drifts
+class cSVGWriter
+{
+public:
+    explicit cSVGWriter(int decimals = 3);
+
+    // the drawing area in mm, y up
+    bool open(const QString& fname, double minX, double minY, double maxX, double maxY);
+    bool close();
+
+    // closed outline, clipper units are multiplied by scale and moved by dx, dy
+    void path(const Path& poly, double scale, double dx, double dy, const char* style);
+
+    // piecewise cubic bezier given as 3n+1 control points
+    void bezier(const std::vector<QVector2D>& ctrl, double dx, double dy, const char* style);
+
+    void line(double x0, double y0, double x1, double y1, const char* style);
+    void text(double x, double y, double size, const QString& text);
+
+private:
+    long long quantize(double v) const;
+    void begin(const char* style);
+    void end();
+    void command(char c);
+    void number(long long q);
+    void moveTo(long long x, long long y);
+    void lineTo(long long x, long long y);
+
+    cBufferedWriter mOut;
+    int mDecimals;
+    double mQuantum;
+    long long mDivisor;
+    long long mX = 0, mY = 0;
+    char mCommand = 0;
+    bool mNumber = false, mDot = false; // last token was a number, did it have a dot
+};
+
+#endif // SVGWRITER_H
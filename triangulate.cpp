@@ -0,0 +1,320 @@
+#include "triangulate.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+struct sNode
+{
+    double x, y;
+    size_t id;
+    size_t prev, next;
+    bool removed;
+};
+
+double area(const sNode& a, const sNode& b, const sNode& c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+bool equals(const sNode& a, const sNode& b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+class cEarClipper
+{
+public:
+    bool run(const Paths& rings, std::vector<size_t>& triangles);
+
+private:
+    size_t addRing(const Path& ring, size_t firstId);
+    bool bridgeFrom(size_t outer, size_t b, const std::vector<size_t>& holes, size_t h);
+    void bridgeHole(size_t outer, size_t hole);
+    bool visible(size_t a, size_t b, const std::vector<size_t>& holes, size_t from);
+    bool locallyInside(size_t a, double x, double y);
+    void buildGrid(size_t start);
+    bool isEar(size_t ear);
+    void remove(size_t n);
+    size_t clip(size_t start, std::vector<size_t>& triangles);
+
+    std::vector<sNode> mNodes;
+    std::vector<std::pair<double, size_t>> mCandidates;
+    std::vector<std::vector<size_t>> mGrid;
+    double mMinX = 0, mMinY = 0, mCell = 1;
+    size_t mCols = 1, mRows = 1;
+};
+
+size_t cEarClipper::addRing(const Path& ring, size_t firstId)
+{
+    size_t first = mNodes.size();
+    for(size_t i=0; i<ring.size(); i++) {
+        sNode n;
+        n.x = ring[i].X;
+        n.y = ring[i].Y;
+        n.id = firstId + i;
+        n.prev = i ? mNodes.size() - 1 : first + ring.size() - 1;
+        n.next = i+1 < ring.size() ? mNodes.size() + 1 : first;
+        n.removed = false;
+        mNodes.push_back(n);
+    }
+    return first;
+}
+
+// the segment a-p leaves a into the interior of the polygon
+bool cEarClipper::locallyInside(size_t a, double x, double y)
+{
+    const sNode& p = mNodes[mNodes[a].prev];
+    const sNode& n = mNodes[mNodes[a].next];
+    sNode q = { x, y, 0, 0, 0, false };
+    if(area(p, mNodes[a], n) >= 0) // convex corner
+        return area(mNodes[a], n, q) >= 0 && area(p, mNodes[a], q) >= 0;
+    return area(mNodes[a], n, q) >= 0 || area(p, mNodes[a], q) >= 0;
+}
+
+static bool segmentsCross(const sNode& a, const sNode& b, const sNode& c, const sNode& d)
+{
+    if(equals(a, c) || equals(a, d) || equals(b, c) || equals(b, d)) return false;
+    double d1 = area(a, b, c), d2 = area(a, b, d), d3 = area(c, d, a), d4 = area(c, d, b);
+    return ((d1 > 0) != (d2 > 0)) && ((d3 > 0) != (d4 > 0)) && d1 && d2 && d3 && d4;
+}
+
+// no edge of the merged outline, of the hole being bridged or of the holes
+// still waiting crosses a-b
+bool cEarClipper::visible(size_t a, size_t b, const std::vector<size_t>& holes, size_t from)
+{
+    size_t p = a;
+    do {
+        if(segmentsCross(mNodes[a], mNodes[b], mNodes[p], mNodes[mNodes[p].next])) return false;
+        p = mNodes[p].next;
+    } while(p != a);
+
+    for(size_t h=from; h<holes.size(); h++) {
+        size_t q = holes[h];
+        do {
+            if(segmentsCross(mNodes[a], mNodes[b], mNodes[q], mNodes[mNodes[q].next])) return false;
+            q = mNodes[q].next;
+        } while(q != holes[h]);
+    }
+    return true;
+}
+
+// bridges hole h from its vertex b to the nearest vertex of the merged
+// outline it can see, the channel has to leave both ends into the interior
+bool cEarClipper::bridgeFrom(size_t outer, size_t b, const std::vector<size_t>& holes, size_t h)
+{
+    const sNode& hp = mNodes[b];
+    mCandidates.clear();
+    size_t p = outer;
+    do {
+        double dx = mNodes[p].x - hp.x, dy = mNodes[p].y - hp.y;
+        mCandidates.push_back(std::make_pair(dx * dx + dy * dy, p));
+        p = mNodes[p].next;
+    } while(p != outer);
+    std::sort(mCandidates.begin(), mCandidates.end());
+
+    for(auto& c : mCandidates) {
+        const sNode& a = mNodes[c.second];
+        if(locallyInside(c.second, hp.x, hp.y) && locallyInside(b, a.x, a.y) && visible(c.second, b, holes, h)) {
+            bridgeHole(c.second, b);
+            return true;
+        }
+    }
+    return false;
+}
+
+// splices the hole in through a zero width channel a-b-...-b'-a'
+void cEarClipper::bridgeHole(size_t a, size_t b)
+{
+    sNode a2 = mNodes[a], b2 = mNodes[b];
+    size_t ia2 = mNodes.size(), ib2 = ia2 + 1;
+    size_t an = mNodes[a].next, bp = mNodes[b].prev;
+
+    mNodes[a].next = b;
+    mNodes[b].prev = a;
+
+    a2.next = an;
+    mNodes[an].prev = ia2;
+
+    a2.prev = ib2;
+    b2.next = ia2;
+
+    b2.prev = bp;
+    mNodes[bp].next = ib2;
+
+    mNodes.push_back(a2);
+    mNodes.push_back(b2);
+}
+
+void cEarClipper::buildGrid(size_t start)
+{
+    double maxX = mNodes[start].x, maxY = mNodes[start].y;
+    mMinX = maxX;
+    mMinY = maxY;
+    size_t count = 0, p = start;
+    do {
+        mMinX = std::min(mMinX, mNodes[p].x); maxX = std::max(maxX, mNodes[p].x);
+        mMinY = std::min(mMinY, mNodes[p].y); maxY = std::max(maxY, mNodes[p].y);
+        count++;
+        p = mNodes[p].next;
+    } while(p != start);
+
+    double w = maxX - mMinX, h = maxY - mMinY;
+    mCell = std::max(std::sqrt(w * h / double(count)) * 2.0, std::max(w, h) / 1024.0);
+    if(!(mCell > 0)) mCell = 1;
+    mCols = size_t(w / mCell) + 1;
+    mRows = size_t(h / mCell) + 1;
+    mGrid.assign(mCols * mRows, std::vector<size_t>());
+
+    p = start;
+    do {
+        size_t cx = size_t((mNodes[p].x - mMinX) / mCell), cy = size_t((mNodes[p].y - mMinY) / mCell);
+        mGrid[cy * mCols + cx].push_back(p);
+        p = mNodes[p].next;
+    } while(p != start);
+}
+
+bool cEarClipper::isEar(size_t ear)
+{
+    const sNode& a = mNodes[mNodes[ear].prev];
+    const sNode& b = mNodes[ear];
+    const sNode& c = mNodes[mNodes[ear].next];
+    if(area(a, b, c) <= 0) return false;
+
+    double x0 = std::min(a.x, std::min(b.x, c.x)), x1 = std::max(a.x, std::max(b.x, c.x));
+    double y0 = std::min(a.y, std::min(b.y, c.y)), y1 = std::max(a.y, std::max(b.y, c.y));
+    size_t cx0 = size_t((x0 - mMinX) / mCell), cx1 = size_t((x1 - mMinX) / mCell);
+    size_t cy0 = size_t((y0 - mMinY) / mCell), cy1 = size_t((y1 - mMinY) / mCell);
+
+    for(size_t cy=cy0; cy<=cy1; cy++) {
+        for(size_t cx=cx0; cx<=cx1; cx++) {
+            for(size_t i : mGrid[cy * mCols + cx]) {
+                const sNode& p = mNodes[i];
+                if(p.removed || p.x < x0 || p.x > x1 || p.y < y0 || p.y > y1) continue;
+                if(equals(p, a) || equals(p, b) || equals(p, c)) continue;
+                if(area(a, b, p) >= 0 && area(b, c, p) >= 0 && area(c, a, p) >= 0)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+void cEarClipper::remove(size_t n)
+{
+    mNodes[mNodes[n].prev].next = mNodes[n].next;
+    mNodes[mNodes[n].next].prev = mNodes[n].prev;
+    mNodes[n].removed = true;
+}
+
+size_t cEarClipper::clip(size_t node, std::vector<size_t>& triangles)
+{
+    size_t left = 0, p = node;
+    do { left++; p = mNodes[p].next; } while(p != node);
+
+    size_t stop = node;
+    bool cleaned = false;
+    while(left > 2) {
+        size_t prev = mNodes[node].prev, next = mNodes[node].next;
+
+        if(isEar(node)) {
+            triangles.push_back(mNodes[prev].id);
+            triangles.push_back(mNodes[node].id);
+            triangles.push_back(mNodes[next].id);
+            remove(node);
+            left--;
+            node = stop = next;
+            cleaned = false;
+            continue;
+        }
+
+        node = next;
+        if(node != stop) continue;
+
+        // a full round without an ear, first drop zero area spikes and
+        // duplicates, then clip the first convex corner no matter what
+        if(!cleaned) {
+            size_t q = node, count = left;
+            for(size_t k=0; k<count && left > 2; k++) {
+                size_t qn = mNodes[q].next;
+                if(equals(mNodes[q], mNodes[qn]) || area(mNodes[mNodes[q].prev], mNodes[q], mNodes[qn]) == 0) {
+                    remove(q);
+                    left--;
+                    if(q == node) node = stop = qn;
+                }
+                q = qn;
+            }
+            cleaned = true;
+            continue;
+        }
+
+        size_t q = node;
+        while(area(mNodes[mNodes[q].prev], mNodes[q], mNodes[mNodes[q].next]) <= 0 && mNodes[q].next != node)
+            q = mNodes[q].next;
+        if(area(mNodes[mNodes[q].prev], mNodes[q], mNodes[mNodes[q].next]) > 0) {
+            triangles.push_back(mNodes[mNodes[q].prev].id);
+            triangles.push_back(mNodes[q].id);
+            triangles.push_back(mNodes[mNodes[q].next].id);
+        }
+        node = stop = mNodes[q].next;
+        remove(q);
+        left--;
+        cleaned = false;
+    }
+    return left;
+}
+
+bool cEarClipper::run(const Paths& rings, std::vector<size_t>& triangles)
+{
+    mNodes.clear();
+    if(rings.empty() || rings[0].size() < 3) return true;
+
+    size_t id = 0;
+    size_t outer = addRing(rings[0], id);
+    id += rings[0].size();
+
+    std::vector<size_t> holes;
+    for(size_t r=1; r<rings.size(); r++) {
+        if(rings[r].size() >= 3) holes.push_back(addRing(rings[r], id));
+        id += rings[r].size();
+    }
+
+    // bridge every hole from its rightmost vertex, rightmost holes first
+    for(auto& h : holes) {
+        size_t start = h, p = h;
+        do {
+            if(mNodes[p].x > mNodes[h].x) h = p;
+            p = mNodes[p].next;
+        } while(p != start);
+    }
+    std::sort(holes.begin(), holes.end(), [this](size_t a, size_t b) { return mNodes[a].x > mNodes[b].x; });
+
+    // when nothing is visible from the rightmost vertex, the other vertices
+    // of the hole are tried in turn; a hole that stays unbridged would be
+    // filled by the triangles, so the cap is reported as failed
+    bool bridged = true;
+    for(size_t h=0; h<holes.size(); h++) {
+        size_t b = holes[h];
+        while(!bridgeFrom(outer, b, holes, h)) {
+            b = mNodes[b].next;
+            if(b == holes[h]) {
+                bridged = false;
+                break;
+            }
+        }
+    }
+
+    buildGrid(outer);
+    clip(outer, triangles);
+    return bridged;
+}
+
+}
+
+bool triangulate(const Paths& rings, std::vector<size_t>& triangles)
+{
+    static thread_local cEarClipper clipper;
+    triangles.clear();
+    return clipper.run(rings, triangles);
+}
@@ -0,0 +1,18 @@
+#ifndef TRIANGULATE_H
+#define TRIANGULATE_H
+
+#include "clipper.h"
+
+#include <vector>
+
+using namespace ClipperLib;
+
+// ear clipping of one polygon with holes: rings[0] is the outer contour
+// (counter clockwise), the rest are holes (clockwise), the way clipper's
+// PolyTree hands them out. Holes are bridged into the outer contour first.
+// Every triangle is three vertex ids, the id of rings[r][i] is the sum of
+// the sizes of the rings before r plus i. Triangles are counter clockwise.
+// Returns false when a hole could not be bridged, its area is then covered.
+bool triangulate(const Paths& rings, std::vector<size_t>& triangles);
+
+#endif // TRIANGULATE_H
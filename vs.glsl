@@ -1,11 +1,30 @@
 #version 430
 
-layout (location=0) in vec3 qt_vertex;
+layout (location=0) in vec2 qt_vertex;
+layout (location=1) in vec4 qt_color;
 
-uniform mat4 qt_modelViewMatrix;
-uniform mat4 qt_projectionMatrix;
+// per instance, constant 0 and white for plain batches
+layout (location=2) in vec2 qt_offset;
+layout (location=3) in vec4 qt_tint;
+
+layout (std140, binding=0) uniform qt_camera
+{
+    mat4 qt_modelViewMatrix;
+    mat4 qt_projectionMatrix;
+};
+
+// every batch lies in one plane
+uniform float qt_z;
+
+// cos, sin and offset of a named outline's placement, identity otherwise
+uniform vec4 qt_place;
+
+out vec4 color;
 
 void main()
 {
-    gl_Position = qt_projectionMatrix * qt_modelViewMatrix * vec4(qt_vertex,1);
+    color = qt_color * qt_tint;
+    vec2 p = qt_vertex + qt_offset;
+    p = vec2(qt_place.x * p.x - qt_place.y * p.y, qt_place.y * p.x + qt_place.x * p.y) + qt_place.zw;
+    gl_Position = qt_projectionMatrix * qt_modelViewMatrix * vec4(p, qt_z, 1);
 }